@@ -11,10 +11,12 @@ import sys
 from requests.auth import HTTPBasicAuth
 
 class ESP32APITester:
-    def __init__(self, esp32_ip="192.168.5.1"):
+    def __init__(self, esp32_ip="192.168.5.1", key_name="test_esp32_api"):
         self.base_url = f"http://{esp32_ip}"
         self.session = requests.Session()
         self.session.timeout = 10
+        self.key_name = key_name
+        self.api_key = None
         
     def test_connection(self):
         """测试基本连接"""
@@ -55,6 +57,39 @@ class ESP32APITester:
             print(f"❌ 登录请求失败: {e}")
             return False
             
+    def create_api_key(self):
+        """用登录会话创建API密钥，之后的请求改用Authorization: Bearer认证"""
+        print(f"🗝️  创建API密钥 - 名称: {self.key_name}")
+        try:
+            # 密钥只在创建时返回一次，同名密钥已存在时先吊销再重新创建
+            self.session.post(
+                f"{self.base_url}/api/keys/revoke",
+                json={"name": self.key_name},
+                headers={'Content-Type': 'application/json'}
+            )
+            response = self.session.post(
+                f"{self.base_url}/api/keys",
+                json={"name": self.key_name},
+                headers={'Content-Type': 'application/json'}
+            )
+            
+            print(f"创建API密钥响应码: {response.status_code}")
+            if response.status_code != 200:
+                print(f"❌ 创建API密钥失败: {response.text}")
+                return False
+            self.api_key = response.json()["key"]
+            
+            # 登出cookie会话，之后只用API密钥
+            self.session.post(f"{self.base_url}/api/logout")
+            self.session.cookies.clear()
+            self.session.headers["Authorization"] = f"Bearer {self.api_key}"
+            print("✅ API密钥已创建，后续请求使用Bearer认证")
+            return True
+            
+        except Exception as e:
+            print(f"❌ 创建API密钥请求失败: {e}")
+            return False
+            
     def test_status_api(self):
         """测试状态API"""
         print("📊 测试状态API")
@@ -125,9 +160,11 @@ class ESP32APITester:
             
         print("\n" + "=" * 50)
         
-        # 2. 测试登录
+        # 2. 测试登录，登录后创建API密钥，后续请求用Bearer认证
         if not self.login():
             print("❌ 登录失败，尝试测试无需认证的API")
+        elif not self.create_api_key():
+            print("⚠️  创建API密钥失败，继续使用cookie会话")
             
         print("\n" + "=" * 50)
         
@@ -177,7 +214,7 @@ def main():
     print("\n" + "=" * 50)
     print("🔍 额外调试测试")
     
-    # 直接测试MQTT API（无认证）
+    # 直接测试MQTT API（使用API密钥时带Bearer认证）
     tester.debug_request(f"http://{esp32_ip}/api/config/mqtt", "POST", {
         "broker_host": "test.mosquitto.org",
         "broker_port": 1883,
@@ -0,0 +1,150 @@
+/**
+ * ini_parser主机性能测试
+ * 生成10到10000个键的INI文本，分别测量加载、查找、修改和保存的耗时
+ *
+ * 用法: ini_parser_bench [重复次数]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "ini_parser.h"
+
+#define KEYS_PER_SECTION 16
+
+static const int s_key_counts[] = { 10, 100, 1000, 10000 };
+
+/**
+ * @brief 单调时钟，单位纳秒
+ */
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief 生成包含count个键的INI文本，整数值和字符串值交替出现
+ */
+static char* make_ini(int count, size_t* out_len) {
+    size_t capacity = (size_t)count * 64 + 64;
+    char* buf = malloc(capacity);
+    size_t len = 0;
+    
+    for (int i = 0; i < count; i++) {
+        if (i % KEYS_PER_SECTION == 0) {
+            len += snprintf(buf + len, capacity - len, "\n[section_%d]\n", i / KEYS_PER_SECTION);
+        }
+        if (i % 2 == 0) {
+            len += snprintf(buf + len, capacity - len, "key_%d=%d\n", i, i * 7);
+        } else {
+            len += snprintf(buf + len, capacity - len, "key_%d = value-%d-xj1core\n", i, i);
+        }
+    }
+    
+    *out_len = len;
+    return buf;
+}
+
+static void key_name(int i, char* section, char* key) {
+    sprintf(section, "section_%d", i / KEYS_PER_SECTION);
+    sprintf(key, "key_%d", i);
+}
+
+static void bench(int count, int rounds, const char* path) {
+    size_t len;
+    char* text = make_ini(count, &len);
+    char section[32];
+    char key[32];
+    char value[48];
+    double t;
+    double load_string = 0, load_rodata = 0, load_file = 0, get = 0, get_int = 0, set = 0, save = 0;
+    
+    FILE* file = fopen(path, "wb");
+    fwrite(text, 1, len, file);
+    fclose(file);
+    
+    ini_config_t* config = ini_config_create();
+    volatile long sink = 0;
+    
+    for (int r = 0; r < rounds; r++) {
+        t = now_ns();
+        ini_config_load_from_string(config, text);
+        load_string += now_ns() - t;
+        
+        t = now_ns();
+        ini_config_load_from_file(config, path);
+        load_file += now_ns() - t;
+        
+        t = now_ns();
+        ini_config_load_from_rodata(config, text, len);
+        load_rodata += now_ns() - t;
+        
+        t = now_ns();
+        for (int i = 0; i < count; i++) {
+            key_name(i, section, key);
+            ini_str_view_t view;
+            if (ini_config_get_view(config, section, key, &view)) {
+                sink += view.len;
+            }
+        }
+        get += now_ns() - t;
+        
+        t = now_ns();
+        for (int i = 0; i < count; i += 2) {
+            key_name(i, section, key);
+            sink += ini_config_get_int(config, section, key, 0);
+        }
+        get_int += now_ns() - t;
+        
+        t = now_ns();
+        for (int i = 0; i < count; i++) {
+            key_name(i, section, key);
+            snprintf(value, sizeof(value), "updated-%d", i + r);
+            ini_config_set_string(config, section, key, value);
+        }
+        set += now_ns() - t;
+        
+        t = now_ns();
+        ini_config_save_to_file(config, path);
+        save += now_ns() - t;
+    }
+    (void)sink;
+    
+    // 键名格式化也计入查找和修改时间，结果偏保守
+    printf("%6d %8zu %12.0f %12.0f %12.0f %10.1f %10.1f %10.1f %12.0f\n",
+           count, len,
+           load_string / rounds / 1000, load_file / rounds / 1000, load_rodata / rounds / 1000,
+           get / rounds / count, get_int / rounds / (count / 2 ? count / 2 : 1), set / rounds / count,
+           save / rounds / 1000);
+    
+    ini_config_destroy(config);
+    free(text);
+}
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 20;
+    if (rounds <= 0) {
+        rounds = 20;
+    }
+    
+    char path[] = "/tmp/ini_parser_bench_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    
+    printf("ini_parser host benchmark, %d rounds\n", rounds);
+    printf("%6s %8s %12s %12s %12s %10s %10s %10s %12s\n",
+           "keys", "bytes", "string(us)", "file(us)", "rodata(us)", "get(ns)", "get_int(ns)", "set(ns)", "save(us)");
+    for (size_t i = 0; i < sizeof(s_key_counts) / sizeof(s_key_counts[0]); i++) {
+        bench(s_key_counts[i], rounds, path);
+    }
+    
+    unlink(path);
+    return 0;
+}
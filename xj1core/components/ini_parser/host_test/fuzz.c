@@ -0,0 +1,77 @@
+/**
+ * ini_parser模糊测试目标，覆盖全部解析入口
+ * 同一份输入分别经过字符串、只读内存和流式解析，随后做查找、修改和重新解析
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ini_parser.h"
+
+static const ini_value_spec_t s_specs[] = {
+    { "a", "int",   INI_VALUE_INT,   -100, 100, 0 },
+    { "a", "bool",  INI_VALUE_BOOL,  0,    0,   1 },
+    { "b", "float", INI_VALUE_FLOAT, 0,    10,  5 },
+};
+
+/**
+ * @brief 对加载结果做查找和修改，检查不会越界
+ */
+static void exercise(ini_config_t* config) {
+    char buf[16];
+    ini_str_view_t view;
+    
+    ini_config_get_string(config, "a", "int", "");
+    ini_config_get_view(config, "", "", &view);
+    ini_config_copy_string(config, "a", "bool", buf, sizeof(buf), "");
+    ini_config_get_int(config, "a", "int", 0);
+    ini_config_get_bool(config, "a", "bool", false);
+    ini_config_get_float(config, "b", "float", 0);
+    ini_config_set_string(config, "a", "int", "42");
+    ini_config_set_string(config, "new", "key", "a value longer than before");
+    ini_config_set_int(config, "a", "bool", 1);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    ini_config_t* config = ini_config_create();
+    if (!config) {
+        return 0;
+    }
+    ini_config_declare(config, s_specs, sizeof(s_specs) / sizeof(s_specs[0]));
+    
+    // 只读内存零拷贝解析，输入不以'\0'结尾
+    ini_config_load_from_rodata(config, (const char*)data, size);
+    exercise(config);
+    
+    // 字符串解析
+    char* text = malloc(size + 1);
+    if (text) {
+        memcpy(text, data, size);
+        text[size] = '\0';
+        ini_config_load_from_string(config, text);
+        exercise(config);
+        free(text);
+    }
+    
+    // 流式解析，按第一个字节决定的块大小切分输入
+    ini_parser_t* parser = ini_parser_create(config);
+    if (parser) {
+        size_t chunk = size > 0 ? (size_t)data[0] % 17 + 1 : 1;
+        for (size_t offset = 0; offset < size; offset += chunk) {
+            size_t len = size - offset < chunk ? size - offset : chunk;
+            char* piece = malloc(len);
+            if (!piece) {
+                break;
+            }
+            memcpy(piece, data + offset, len);
+            ini_parser_feed(parser, piece, len);
+            free(piece);
+        }
+        ini_parser_finish(parser);
+        ini_parser_destroy(parser);
+        exercise(config);
+    }
+    
+    ini_config_destroy(config);
+    return 0;
+}
@@ -0,0 +1,33 @@
+/**
+ * 没有libFuzzer时的回放程序：依次把命令行给出的文件作为输入调用模糊测试目标
+ *
+ * 用法: ini_parser_fuzz <文件>...
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        FILE* file = fopen(argv[i], "rb");
+        if (!file) {
+            perror(argv[i]);
+            return 1;
+        }
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        
+        uint8_t* data = malloc(size > 0 ? size : 1);
+        size_t read_len = fread(data, 1, size > 0 ? size : 0, file);
+        fclose(file);
+        
+        LLVMFuzzerTestOneInput(data, read_len);
+        free(data);
+        printf("%s: ok (%zu bytes)\n", argv[i], read_len);
+    }
+    return 0;
+}
@@ -24,37 +24,88 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "esp_err.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define INI_MAX_LINE_LENGTH 256
-#define INI_MAX_SECTION_NAME 64
-#define INI_MAX_KEY_NAME 64
-#define INI_MAX_VALUE_LENGTH 128
+/**
+ * @brief 只读字符串视图
+ * @note 指向的内容不一定以'\0'结尾，使用时必须以len为准
+ */
+typedef struct {
+    const char* ptr;
+    size_t len;
+} ini_str_view_t;
+
+#define INI_SAVE_TMP_SUFFIX ".tmp"    // 保存时先写入的临时文件后缀
 
 /**
  * @brief INI配置项结构体
+ * @note 字符串保存在配置句柄的arena中，或在零拷贝加载时直接指向源数据，长度不受限制
  */
 typedef struct {
-    char section[INI_MAX_SECTION_NAME];
-    char key[INI_MAX_KEY_NAME];
-    char value[INI_MAX_VALUE_LENGTH];
+    ini_str_view_t section;
+    ini_str_view_t key;
+    ini_str_view_t value;
 } ini_item_t;
 
+/**
+ * @brief 配置值类型
+ */
+typedef enum {
+    INI_VALUE_INT,
+    INI_VALUE_BOOL,                     // true/false、yes/no、on/off、1/0，不区分大小写
+    INI_VALUE_FLOAT,
+} ini_value_type_t;
+
+/**
+ * @brief 配置值的声明：类型、取值范围和默认值
+ * @note 值无法按类型解析或超出[min, max]时，加载时输出一次警告，类型化读取返回default_value；
+ *       INI_VALUE_BOOL忽略min和max，default_value非0为true
+ */
+typedef struct {
+    const char* section;
+    const char* key;
+    ini_value_type_t type;
+    int32_t min;
+    int32_t max;
+    int32_t default_value;
+} ini_value_spec_t;
+
+/**
+ * @brief INI配置句柄创建选项
+ */
+typedef enum {
+    INI_CONFIG_FLAG_NONE  = 0,
+    INI_CONFIG_FLAG_PSRAM = (1 << 0),   // 配置项和字符串arena优先分配在PSRAM，不足时回退到内部RAM
+} ini_config_flags_t;
+
 /**
  * @brief INI配置文件句柄
  */
 typedef struct ini_config_s ini_config_t;
 
+/**
+ * @brief INI流式解析器句柄
+ */
+typedef struct ini_parser_s ini_parser_t;
+
 /**
  * @brief 创建INI配置句柄
  * @return INI配置句柄，失败返回NULL
  */
 ini_config_t* ini_config_create(void);
 
+/**
+ * @brief 按指定选项创建INI配置句柄
+ * @param flags ini_config_flags_t选项组合
+ * @return INI配置句柄，失败返回NULL
+ */
+ini_config_t* ini_config_create_with_flags(uint32_t flags);
+
 /**
  * @brief 销毁INI配置句柄
  * @param config INI配置句柄
@@ -65,10 +116,21 @@ void ini_config_destroy(ini_config_t* config);
  * @brief 从文件加载INI配置
  * @param config INI配置句柄
  * @param filename 文件名
- * @return ESP_OK成功，其他值失败
+ * @return ESP_OK成功，ESP_ERR_NOT_FOUND文件不存在，ESP_ERR_INVALID_CRC校验行与内容不符，其他值失败
+ * @note 没有校验行的文件（手工编辑或旧版本保存）不做校验，因此不能发现正好截掉了校验行的文件
  */
 esp_err_t ini_config_load_from_file(ini_config_t* config, const char* filename);
 
+/**
+ * @brief 从ini_config_save_to_file保存的文件加载INI配置，要求文件带有校验行
+ * @param config INI配置句柄
+ * @param filename 文件名
+ * @return ESP_OK成功，ESP_ERR_NOT_FOUND文件不存在，ESP_ERR_INVALID_CRC缺少校验行或校验行与内容不符，
+ *         其他值失败
+ * @note 用于从保存时的临时文件恢复：写入被打断的文件通常正好缺少最后的校验行
+ */
+esp_err_t ini_config_load_from_file_verified(ini_config_t* config, const char* filename);
+
 /**
  * @brief 从字符串加载INI配置
  * @param config INI配置句柄
@@ -77,11 +139,58 @@ esp_err_t ini_config_load_from_file(ini_config_t* config, const char* filename);
  */
 esp_err_t ini_config_load_from_string(ini_config_t* config, const char* ini_string);
 
+/**
+ * @brief 零拷贝加载只读内存中的INI配置（如EMBED_FILES嵌入到flash的文件）
+ * @param config INI配置句柄
+ * @param data INI文本起始地址，生命周期必须长于配置句柄
+ * @param len INI文本长度，文本不需要以'\0'结尾
+ * @return ESP_OK成功，其他值失败
+ * @note 配置项以视图形式直接指向data，不复制字符串；ini_config_get_string
+ *       会在第一次访问某个值时把它复制到arena以提供'\0'结尾的字符串，
+ *       需要零拷贝读取时请使用ini_config_get_view或ini_config_copy_string
+ */
+esp_err_t ini_config_load_from_rodata(ini_config_t* config, const char* data, size_t len);
+
+/**
+ * @brief 创建流式解析器，边接收边解析INI文本（如HTTP或MQTT上传的配置）
+ * @param config 解析结果写入的INI配置句柄，原有配置项会被清空
+ * @return 解析器句柄，失败返回NULL
+ * @note 解析状态全部保存在解析器句柄中，不同任务可以各自使用自己的解析器和配置句柄同时解析；
+ *       同一个配置句柄同一时间只能被一个解析器使用
+ */
+ini_parser_t* ini_parser_create(ini_config_t* config);
+
+/**
+ * @brief 向解析器输入一块数据
+ * @param parser 解析器句柄
+ * @param chunk 数据块，可以在任意位置切分，调用返回后即可释放
+ * @param len 数据块长度
+ * @return ESP_OK成功，其他值失败，失败后配置句柄被清空，后续输入返回同一错误码
+ * @note 完整的行直接从数据块解析，只有跨数据块的行才复制到按需增长的行缓冲区，行长度不受限制
+ */
+esp_err_t ini_parser_feed(ini_parser_t* parser, const char* chunk, size_t len);
+
+/**
+ * @brief 结束输入，解析最后一行（可以没有换行符）
+ * @param parser 解析器句柄
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t ini_parser_finish(ini_parser_t* parser);
+
+/**
+ * @brief 销毁流式解析器，不影响已解析到配置句柄中的配置项
+ * @param parser 解析器句柄
+ */
+void ini_parser_destroy(ini_parser_t* parser);
+
 /**
  * @brief 保存INI配置到文件
  * @param config INI配置句柄
  * @param filename 文件名
  * @return ESP_OK成功，其他值失败
+ * @note 整个文件先在内存中渲染并追加CRC32校验行，一次写入filename加INI_SAVE_TMP_SUFFIX
+ *       的临时文件后再重命名为filename。SPIFFS不能重命名覆盖，中间会先删除旧文件，
+ *       若此时断电，正式文件不存在而临时文件完整，调用者应从临时文件恢复
  */
 esp_err_t ini_config_save_to_file(ini_config_t* config, const char* filename);
 
@@ -92,19 +201,78 @@ esp_err_t ini_config_save_to_file(ini_config_t* config, const char* filename);
  * @param key 键名
  * @param default_value 默认值
  * @return 配置值，如果不存在返回默认值
+ * @note 返回的指针只在对该配置句柄的下一次set/remove/load/clear之前有效：写入可能原地
+ *       覆盖旧值，删除或写入产生的碎片过多时会整理arena并移动所有字符串。需要长期
+ *       保存的值请用ini_config_copy_string复制
  */
 const char* ini_config_get_string(ini_config_t* config, const char* section, const char* key, const char* default_value);
 
+/**
+ * @brief 获取值的只读视图，不复制字符串
+ * @param config INI配置句柄
+ * @param section 段名
+ * @param key 键名
+ * @param value 输出值视图，内容不一定以'\0'结尾
+ * @return true存在，false不存在
+ * @note 视图的有效期与ini_config_get_string返回的指针相同
+ */
+bool ini_config_get_view(ini_config_t* config, const char* section, const char* key, ini_str_view_t* value);
+
+/**
+ * @brief 将值复制到调用者的缓冲区
+ * @param config INI配置句柄
+ * @param section 段名
+ * @param key 键名
+ * @param buffer 输出缓冲区，结果总是以'\0'结尾
+ * @param buffer_size 缓冲区大小
+ * @param default_value 默认值，不存在时复制默认值
+ * @return ESP_OK成功，ESP_ERR_INVALID_SIZE值被截断
+ */
+esp_err_t ini_config_copy_string(ini_config_t* config, const char* section, const char* key,
+                                 char* buffer, size_t buffer_size, const char* default_value);
+
 /**
  * @brief 获取整数值
  * @param config INI配置句柄
  * @param section 段名
  * @param key 键名
  * @param default_value 默认值
- * @return 配置值，如果不存在返回默认值
+ * @return 配置值，如果不存在或不是整数返回默认值
+ * @note 整数形式在加载或修改时解析并缓存，读取时不再转换
  */
 int ini_config_get_int(ini_config_t* config, const char* section, const char* key, int default_value);
 
+/**
+ * @brief 获取布尔值
+ * @param config INI配置句柄
+ * @param section 段名
+ * @param key 键名
+ * @param default_value 默认值
+ * @return 配置值，如果不存在或不是布尔值返回默认值
+ */
+bool ini_config_get_bool(ini_config_t* config, const char* section, const char* key, bool default_value);
+
+/**
+ * @brief 获取浮点值
+ * @param config INI配置句柄
+ * @param section 段名
+ * @param key 键名
+ * @param default_value 默认值
+ * @return 配置值，如果不存在或不是数值返回默认值
+ */
+float ini_config_get_float(ini_config_t* config, const char* section, const char* key, float default_value);
+
+/**
+ * @brief 声明配置值的类型和取值范围
+ * @param config INI配置句柄
+ * @param specs 声明数组，生命周期必须长于配置句柄（通常为静态常量表）
+ * @param count 声明数量
+ * @return ESP_OK成功，其他值失败
+ * @note 立即检查已加载的配置项，之后每次加载和修改时自动检查；
+ *       无效值只在检查时警告一次，类型化读取直接返回缓存的默认值
+ */
+esp_err_t ini_config_declare(ini_config_t* config, const ini_value_spec_t* specs, size_t count);
+
 /**
  * @brief 设置字符串值
  * @param config INI配置句柄
@@ -134,6 +302,37 @@ esp_err_t ini_config_set_int(ini_config_t* config, const char* section, const ch
  */
 bool ini_config_has_key(ini_config_t* config, const char* section, const char* key);
 
+/**
+ * @brief 删除指定的键
+ * @param config INI配置句柄
+ * @param section 段名
+ * @param key 键名
+ * @return ESP_OK成功，ESP_ERR_NOT_FOUND键不存在，其他值失败
+ */
+esp_err_t ini_config_remove_key(ini_config_t* config, const char* section, const char* key);
+
+/**
+ * @brief 删除在另一份配置中存在且值相同的键
+ * @param config INI配置句柄
+ * @param other 用于比较的INI配置句柄，不会被修改
+ * @return 删除的键数
+ * @note 用于把完整配置缩减为相对于基础配置的差异
+ */
+int ini_config_remove_equal(ini_config_t* config, const ini_config_t* other);
+
+/**
+ * @brief 删除所有配置项，保留已声明的取值规则
+ * @param config INI配置句柄
+ */
+void ini_config_clear(ini_config_t* config);
+
+/**
+ * @brief 获取配置项数量
+ * @param config INI配置句柄
+ * @return 配置项数量
+ */
+int ini_config_get_item_count(const ini_config_t* config);
+
 #ifdef __cplusplus
 }
 #endif
@@ -20,104 +20,744 @@
 #include "ini_parser.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include <inttypes.h>
+#include <errno.h>
+#include <strings.h>
+#include <unistd.h>
 
 static const char *TAG = "ini_parser";
 
-#define MAX_INI_ITEMS 100
+#define INI_INITIAL_ITEMS 32        // 配置项数组初始容量，不足时按倍数扩容
+#define INI_ARENA_MIN_BLOCK 256     // arena追加块的最小字节数
+#define INI_ARENA_COMPACT_MIN 1024  // 废弃字节超过该值且超过已用一半时整理arena
+#define INI_HASH_EMPTY (-1)
+#define INI_CRC_TRAILER_PREFIX "# crc32="  // 保存时追加在文件末尾的校验行前缀
+
+#define INI_ENTRY_NAMES_BORROWED (1 << 0)   // 段名和键名指向外部只读缓冲区，未以'\0'结尾
+#define INI_ENTRY_VALUE_BORROWED (1 << 1)   // 值指向外部只读缓冲区，未以'\0'结尾
+
+#define INI_TYPED_INT   (1 << 0)            // int_value有效
+#define INI_TYPED_BOOL  (1 << 1)            // bool_value有效
+#define INI_TYPED_FLOAT (1 << 2)            // float_value有效
+#define INI_NUMBER_MAX_LEN 31               // 超过该长度的值不按数值解析
+
+/**
+ * @brief arena内存块，字符串按顺序追加，整体释放
+ */
+typedef struct ini_arena_block_s {
+    struct ini_arena_block_s* next;
+    size_t size;
+    size_t used;
+    char data[];
+} ini_arena_block_t;
+
+/**
+ * @brief 内部配置项，在公开的视图之外记录哈希值和字符串归属
+ */
+typedef struct {
+    ini_item_t item;
+    uint32_t hash;
+    uint8_t flags;
+    uint8_t typed;                      // INI_TYPED_*，加载或修改时解析一次，读取时不再转换
+    bool bool_value;
+    int32_t int_value;
+    float float_value;
+    const ini_value_spec_t* spec;       // 声明的类型和取值范围，未声明为NULL
+} ini_entry_t;
 
 /**
  * @brief INI配置文件句柄结构体
  */
 struct ini_config_s {
-    ini_item_t items[MAX_INI_ITEMS];
+    ini_entry_t* entries;               // 配置项数组，按需扩容
     int item_count;
+    int item_capacity;
+    int32_t* index;                     // 开放寻址哈希索引，存放entries下标
+    uint32_t index_size;                // 索引槽位数，2的幂且不小于item_capacity的两倍
+    ini_arena_block_t* arena;           // 字符串arena，头部为当前追加块
+    size_t arena_used;                  // arena中已分配的字节数
+    size_t arena_waste;                 // 被覆盖而不再引用的字节数
+    uint32_t caps;                      // 内存分配能力
+    const ini_value_spec_t* specs;      // ini_config_declare声明的取值规则
+    size_t spec_count;
 };
 
 /**
- * @brief 去除字符串首尾空白字符
+ * @brief 流式解析器状态
+ */
+struct ini_parser_s {
+    ini_config_t* config;
+    ini_str_view_t section;             // 当前段名，位于config的arena中
+    char* line;                         // 跨数据块的未完成行
+    size_t line_len;
+    size_t line_capacity;
+    esp_err_t error;                    // 第一次出错的错误码，之后的输入都被忽略
+};
+
+/**
+ * @brief 由C字符串构造视图
+ */
+static inline ini_str_view_t make_view(const char* str) {
+    ini_str_view_t view = { .ptr = str, .len = strlen(str) };
+    return view;
+}
+
+/**
+ * @brief 比较两个视图内容是否相同
+ */
+static inline bool view_equals(ini_str_view_t a, ini_str_view_t b) {
+    return a.len == b.len && memcmp(a.ptr, b.ptr, a.len) == 0;
+}
+
+/**
+ * @brief 按句柄的内存能力分配内存，PSRAM不可用时回退到内部RAM
+ */
+static void* config_alloc(const ini_config_t* config, size_t size) {
+    void* ptr = heap_caps_malloc(size, config->caps);
+    if (!ptr && config->caps != MALLOC_CAP_8BIT) {
+        ptr = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    return ptr;
+}
+
+/**
+ * @brief 释放arena的所有内存块
  */
-static char* trim_whitespace(char* str) {
-    char* end;
+static void arena_reset(ini_config_t* config) {
+    ini_arena_block_t* block = config->arena;
+    while (block) {
+        ini_arena_block_t* next = block->next;
+        free(block);
+        block = next;
+    }
+    config->arena = NULL;
+    config->arena_used = 0;
+    config->arena_waste = 0;
+}
+
+/**
+ * @brief 从arena分配内存
+ * @param min_block 需要新块时块的最小大小，加载文件时传入文件大小使arena一次分配到位
+ */
+static char* arena_alloc(ini_config_t* config, size_t size, size_t min_block) {
+    ini_arena_block_t* block = config->arena;
     
-    // 去除前导空白
-    while (*str == ' ' || *str == '\t' || *str == '\n' || *str == '\r') {
-        str++;
+    if (!block || block->size - block->used < size) {
+        size_t block_size = size > min_block ? size : min_block;
+        if (block_size < INI_ARENA_MIN_BLOCK) {
+            block_size = INI_ARENA_MIN_BLOCK;
+        }
+        
+        block = config_alloc(config, sizeof(ini_arena_block_t) + block_size);
+        if (!block) {
+            ESP_LOGE(TAG, "Failed to allocate %d bytes for INI arena", (int)block_size);
+            return NULL;
+        }
+        block->size = block_size;
+        block->used = 0;
+        block->next = config->arena;
+        config->arena = block;
     }
     
-    if (*str == 0) {
-        return str;
+    char* ptr = block->data + block->used;
+    block->used += size;
+    config->arena_used += size;
+    return ptr;
+}
+
+/**
+ * @brief 将视图内容复制到arena，结果以'\0'结尾
+ */
+static bool arena_copy_view(ini_config_t* config, ini_str_view_t* view) {
+    char* copy = arena_alloc(config, view->len + 1, 0);
+    if (!copy) {
+        return false;
     }
+    memcpy(copy, view->ptr, view->len);
+    copy[view->len] = '\0';
+    view->ptr = copy;
+    return true;
+}
+
+/**
+ * @brief 计算段名+键名的FNV-1a哈希值
+ */
+static uint32_t hash_section_key(ini_str_view_t section, ini_str_view_t key) {
+    uint32_t hash = 2166136261u;
     
-    // 去除尾部空白
-    end = str + strlen(str) - 1;
-    while (end > str && (*end == ' ' || *end == '\t' || *end == '\n' || *end == '\r')) {
-        end--;
+    for (size_t i = 0; i < section.len; i++) {
+        hash = (hash ^ (uint8_t)section.ptr[i]) * 16777619u;
+    }
+    // 段名与键名之间加入分隔符，避免"ab"+"c"与"a"+"bc"冲突
+    hash = (hash ^ 0xFFu) * 16777619u;
+    for (size_t i = 0; i < key.len; i++) {
+        hash = (hash ^ (uint8_t)key.ptr[i]) * 16777619u;
     }
     
-    *(end + 1) = '\0';
-    return str;
+    return hash;
 }
 
 /**
- * @brief 检查是否为段名行
+ * @brief 在哈希索引中查找配置项
+ * @return 配置项下标，不存在返回-1
  */
-static bool is_section_line(const char* line, char* section_name) {
-    const char* trimmed = trim_whitespace((char*)line);
-    int len = strlen(trimmed);
+static int find_entry(const ini_config_t* config, ini_str_view_t section, ini_str_view_t key) {
+    if (!config->index) {
+        return -1;
+    }
     
-    if (len < 3 || trimmed[0] != '[' || trimmed[len-1] != ']') {
-        return false;
+    uint32_t mask = config->index_size - 1;
+    uint32_t hash = hash_section_key(section, key);
+    uint32_t slot = hash & mask;
+    
+    // 线性探测，遇到空槽位即表示不存在
+    while (config->index[slot] != INI_HASH_EMPTY) {
+        const ini_entry_t* entry = &config->entries[config->index[slot]];
+        if (entry->hash == hash &&
+            view_equals(entry->item.section, section) &&
+            view_equals(entry->item.key, key)) {
+            return config->index[slot];
+        }
+        slot = (slot + 1) & mask;
     }
     
-    strncpy(section_name, trimmed + 1, len - 2);
-    section_name[len - 2] = '\0';
-    return true;
+    return -1;
+}
+
+/**
+ * @brief 按C字符串查找配置项
+ */
+static int find_item(const ini_config_t* config, const char* section, const char* key) {
+    return find_entry(config, make_view(section), make_view(key));
 }
 
 /**
- * @brief 解析键值对
+ * @brief 将配置项加入哈希索引
  */
-static bool parse_key_value(const char* line, char* key, char* value) {
-    char* equal_pos = strchr(line, '=');
+static void index_insert(ini_config_t* config, int i) {
+    uint32_t mask = config->index_size - 1;
+    uint32_t slot = config->entries[i].hash & mask;
+    
+    while (config->index[slot] != INI_HASH_EMPTY) {
+        slot = (slot + 1) & mask;
+    }
+    config->index[slot] = i;
+}
+
+/**
+ * @brief 重建哈希索引
+ * @note 重复的段名+键名只索引第一次出现的项，与原线性查找的结果一致
+ */
+static void rebuild_index(ini_config_t* config) {
+    memset(config->index, 0xFF, config->index_size * sizeof(int32_t));
+    
+    for (int i = 0; i < config->item_count; i++) {
+        const ini_item_t* item = &config->entries[i].item;
+        if (find_entry(config, item->section, item->key) < 0) {
+            index_insert(config, i);
+        }
+    }
+}
+
+/**
+ * @brief 确保配置项数组至少能容纳capacity项，必要时扩容并重建索引
+ */
+static esp_err_t reserve_items(ini_config_t* config, int capacity) {
+    if (capacity <= config->item_capacity) {
+        return ESP_OK;
+    }
+    
+    int new_capacity = config->item_capacity > 0 ? config->item_capacity : INI_INITIAL_ITEMS;
+    while (new_capacity < capacity) {
+        new_capacity *= 2;
+    }
+    uint32_t new_index_size = 1;
+    while (new_index_size < (uint32_t)new_capacity * 2) {
+        new_index_size <<= 1;
+    }
+    
+    ini_entry_t* entries = config_alloc(config, new_capacity * sizeof(ini_entry_t));
+    int32_t* index = config_alloc(config, new_index_size * sizeof(int32_t));
+    if (!entries || !index) {
+        free(entries);
+        free(index);
+        ESP_LOGE(TAG, "Failed to grow INI config to %d items", new_capacity);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    if (config->item_count > 0) {
+        memcpy(entries, config->entries, config->item_count * sizeof(ini_entry_t));
+    }
+    free(config->entries);
+    free(config->index);
+    
+    config->entries = entries;
+    config->index = index;
+    config->item_capacity = new_capacity;
+    config->index_size = new_index_size;
+    rebuild_index(config);
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief 解析值的整数、布尔和浮点形式，结果缓存在配置项中
+ */
+static void entry_parse_typed(ini_entry_t* entry) {
+    entry->typed = 0;
+    
+    const ini_str_view_t* value = &entry->item.value;
+    if (value->len == 0 || value->len > INI_NUMBER_MAX_LEN) {
+        return;
+    }
+    
+    // 借用的值不以'\0'结尾，先复制到栈上再转换
+    char str_value[INI_NUMBER_MAX_LEN + 1];
+    memcpy(str_value, value->ptr, value->len);
+    str_value[value->len] = '\0';
+    char* end = NULL;
+    
+    errno = 0;
+    long int_value = strtol(str_value, &end, 10);
+    if (errno == 0 && end == str_value + value->len && int_value >= INT32_MIN && int_value <= INT32_MAX) {
+        entry->int_value = (int32_t)int_value;
+        entry->typed |= INI_TYPED_INT;
+    }
+    
+    errno = 0;
+    float float_value = strtof(str_value, &end);
+    if (errno == 0 && end == str_value + value->len) {
+        entry->float_value = float_value;
+        entry->typed |= INI_TYPED_FLOAT;
+    }
+    
+    if (!strcasecmp(str_value, "true") || !strcasecmp(str_value, "yes") ||
+        !strcasecmp(str_value, "on") || !strcmp(str_value, "1")) {
+        entry->bool_value = true;
+        entry->typed |= INI_TYPED_BOOL;
+    } else if (!strcasecmp(str_value, "false") || !strcasecmp(str_value, "no") ||
+               !strcasecmp(str_value, "off") || !strcmp(str_value, "0")) {
+        entry->bool_value = false;
+        entry->typed |= INI_TYPED_BOOL;
+    }
+}
+
+/**
+ * @brief 按声明的类型和范围检查配置项，无效时缓存默认值并输出一次警告
+ */
+static void entry_apply_spec(ini_entry_t* entry) {
+    const ini_value_spec_t* spec = entry->spec;
+    bool valid = true;
+    
+    switch (spec->type) {
+    case INI_VALUE_INT:
+        valid = (entry->typed & INI_TYPED_INT) &&
+                entry->int_value >= spec->min && entry->int_value <= spec->max;
+        if (!valid) {
+            entry->int_value = spec->default_value;
+            entry->typed |= INI_TYPED_INT;
+        }
+        break;
+    case INI_VALUE_BOOL:
+        valid = entry->typed & INI_TYPED_BOOL;
+        if (!valid) {
+            entry->bool_value = spec->default_value != 0;
+            entry->typed |= INI_TYPED_BOOL;
+        }
+        break;
+    case INI_VALUE_FLOAT:
+        valid = (entry->typed & INI_TYPED_FLOAT) &&
+                entry->float_value >= spec->min && entry->float_value <= spec->max;
+        if (!valid) {
+            entry->float_value = (float)spec->default_value;
+            entry->typed |= INI_TYPED_FLOAT;
+        }
+        break;
+    default:
+        break;
+    }
+    
+    if (valid) {
+        return;
+    }
+    if (spec->type == INI_VALUE_BOOL) {
+        ESP_LOGW(TAG, "[%s] %s = '%.*s' is not a boolean, using default %s",
+                 spec->section, spec->key, (int)entry->item.value.len, entry->item.value.ptr,
+                 spec->default_value ? "true" : "false");
+    } else {
+        ESP_LOGW(TAG, "[%s] %s = '%.*s' is invalid (expected range [%" PRId32 ", %" PRId32 "]), using default %" PRId32,
+                 spec->section, spec->key, (int)entry->item.value.len, entry->item.value.ptr,
+                 spec->min, spec->max, spec->default_value);
+    }
+}
+
+/**
+ * @brief 追加配置项并加入索引，字符串的归属由flags说明
+ */
+static esp_err_t append_item(ini_config_t* config, ini_str_view_t section, ini_str_view_t key,
+                             ini_str_view_t value, uint8_t flags) {
+    esp_err_t ret = reserve_items(config, config->item_count + 1);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    int i = config->item_count;
+    ini_entry_t* entry = &config->entries[i];
+    entry->item.section = section;
+    entry->item.key = key;
+    entry->item.value = value;
+    entry->hash = hash_section_key(section, key);
+    entry->flags = flags;
+    entry->spec = NULL;
+    entry_parse_typed(entry);
+    
+    // 重复键只保留第一次出现的项在索引中
+    if (find_entry(config, section, key) < 0) {
+        index_insert(config, i);
+    }
+    config->item_count++;
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief 查找已有的段名字符串，相同段名的配置项共享同一份字符串
+ */
+static bool intern_section(ini_config_t* config, ini_str_view_t* section) {
+    for (int i = config->item_count - 1; i >= 0; i--) {
+        const ini_entry_t* entry = &config->entries[i];
+        if (view_equals(entry->item.section, *section)) {
+            section->ptr = entry->item.section.ptr;
+            return true;
+        }
+    }
+    return arena_copy_view(config, section);
+}
+
+/**
+ * @brief 整理arena，只保留仍被引用的字符串，借用外部缓冲区的字符串保持不变
+ */
+static esp_err_t arena_compact(ini_config_t* config) {
+    ini_config_t fresh = {
+        .caps = config->caps,
+    };
+    
+    // 先一次性分配足够的新块，避免整理过程中失败
+    size_t live = config->arena_used - config->arena_waste;
+    if (!arena_alloc(&fresh, 0, live)) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // 复制结果先写入临时视图，全部成功后才改写配置项，失败时配置项仍指向旧arena
+    ini_str_view_t* staged = NULL;
+    if (config->item_count > 0) {
+        staged = config_alloc(config, sizeof(ini_str_view_t) * 3 * config->item_count);
+        if (!staged) {
+            arena_reset(&fresh);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    for (int i = 0; i < config->item_count; i++) {
+        const ini_entry_t* entry = &config->entries[i];
+        ini_str_view_t* views = &staged[3 * i];
+        views[0] = entry->item.section;
+        views[1] = entry->item.key;
+        views[2] = entry->item.value;
+        bool ok = true;
+        
+        if (!(entry->flags & INI_ENTRY_NAMES_BORROWED)) {
+            // 段名优先复用前面已整理的相同段名
+            bool found = false;
+            for (int j = 0; j < i && !found; j++) {
+                const ini_entry_t* prev = &config->entries[j];
+                if (!(prev->flags & INI_ENTRY_NAMES_BORROWED) &&
+                    view_equals(prev->item.section, entry->item.section)) {
+                    views[0].ptr = staged[3 * j].ptr;
+                    found = true;
+                }
+            }
+            ok = (found || arena_copy_view(&fresh, &views[0])) &&
+                 arena_copy_view(&fresh, &views[1]);
+        }
+        if (ok && !(entry->flags & INI_ENTRY_VALUE_BORROWED)) {
+            ok = arena_copy_view(&fresh, &views[2]);
+        }
+        if (!ok) {
+            // 新块按存活字节数分配，理论上不会走到这里
+            free(staged);
+            arena_reset(&fresh);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    for (int i = 0; i < config->item_count; i++) {
+        ini_entry_t* entry = &config->entries[i];
+        entry->item.section = staged[3 * i];
+        entry->item.key = staged[3 * i + 1];
+        entry->item.value = staged[3 * i + 2];
+    }
+    free(staged);
+    
+    arena_reset(config);
+    config->arena = fresh.arena;
+    config->arena_used = fresh.arena_used;
+    
+    ESP_LOGD(TAG, "INI arena compacted to %d bytes", (int)config->arena_used);
+    return ESP_OK;
+}
+
+/**
+ * @brief 判断是否为空白字符
+ */
+static inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/**
+ * @brief 去除[start, end)区间首尾的空白字符
+ */
+static void trim_span(const char** start, const char** end) {
+    while (*start < *end && is_space(**start)) {
+        (*start)++;
+    }
+    while (*end > *start && is_space(*(*end - 1))) {
+        (*end)--;
+    }
+}
+
+/**
+ * @brief 把声明的取值规则绑定到已加载的配置项并检查，加载完成后调用
+ */
+static void apply_specs(ini_config_t* config) {
+    for (size_t i = 0; i < config->spec_count; i++) {
+        const ini_value_spec_t* spec = &config->specs[i];
+        int index = find_item(config, spec->section, spec->key);
+        if (index >= 0) {
+            config->entries[index].spec = spec;
+            entry_apply_spec(&config->entries[index]);
+        }
+    }
+}
+
+/**
+ * @brief 查找配置项对应的取值规则
+ */
+static const ini_value_spec_t* lookup_spec(const ini_config_t* config, const char* section, const char* key) {
+    for (size_t i = 0; i < config->spec_count; i++) {
+        if (!strcmp(config->specs[i].section, section) && !strcmp(config->specs[i].key, key)) {
+            return &config->specs[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 行内字符串的存放方式
+ */
+typedef enum {
+    INI_LINE_BORROWED,  // 行位于外部只读内存，配置项直接指向它
+    INI_LINE_IN_PLACE,  // 行位于arena中，就地写入'\0'
+    INI_LINE_COPY,      // 行位于临时缓冲区，字符串复制到arena
+} ini_line_mode_t;
+
+/**
+ * @brief 解析一行INI文本
+ * @param section 当前段名，遇到段名行时更新；INI_LINE_COPY模式下指向arena中的副本
+ */
+static esp_err_t parse_line(ini_config_t* config, const char* start, const char* end,
+                            ini_str_view_t* section, ini_line_mode_t mode) {
+    trim_span(&start, &end);
+    
+    // 跳过空行和注释行
+    if (start == end || *start == '#' || *start == ';') {
+        return ESP_OK;
+    }
+    
+    // 检查是否为段名
+    if (end - start >= 3 && *start == '[' && *(end - 1) == ']') {
+        section->ptr = start + 1;
+        section->len = end - start - 2;
+        if (mode == INI_LINE_IN_PLACE) {
+            *(char*)(end - 1) = '\0';
+        } else if (mode == INI_LINE_COPY && !intern_section(config, section)) {
+            return ESP_ERR_NO_MEM;
+        }
+        ESP_LOGD(TAG, "Found section: [%.*s]", (int)section->len, section->ptr);
+        return ESP_OK;
+    }
+    
+    // 解析键值对
+    const char* equal_pos = memchr(start, '=', end - start);
     if (!equal_pos) {
-        return false;
+        return ESP_OK;
     }
     
-    // 提取键名
-    int key_len = equal_pos - line;
-    strncpy(key, line, key_len);
-    key[key_len] = '\0';
-    trim_whitespace(key);
+    const char* key_start = start;
+    const char* key_end = equal_pos;
+    const char* value_start = equal_pos + 1;
+    const char* value_end = end;
+    trim_span(&key_start, &key_end);
+    trim_span(&value_start, &value_end);
     
-    // 提取值
-    strcpy(value, equal_pos + 1);
-    trim_whitespace(value);
+    ini_str_view_t key = { .ptr = key_start, .len = key_end - key_start };
+    ini_str_view_t value = { .ptr = value_start, .len = value_end - value_start };
+    uint8_t flags = 0;
     
-    return true;
+    if (mode == INI_LINE_BORROWED) {
+        flags = INI_ENTRY_NAMES_BORROWED | INI_ENTRY_VALUE_BORROWED;
+    } else if (mode == INI_LINE_IN_PLACE) {
+        *(char*)key_end = '\0';
+        *(char*)value_end = '\0';
+    } else {
+        // 键和值放在同一次分配中
+        char* copy = arena_alloc(config, key.len + value.len + 2, 0);
+        if (!copy) {
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(copy, key.ptr, key.len);
+        copy[key.len] = '\0';
+        memcpy(copy + key.len + 1, value.ptr, value.len);
+        copy[key.len + 1 + value.len] = '\0';
+        key.ptr = copy;
+        value.ptr = copy + key.len + 1;
+    }
+    
+    esp_err_t ret = append_item(config, *section, key, value, flags);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    ESP_LOGD(TAG, "Loaded: [%.*s] %.*s = %.*s", (int)section->len, section->ptr,
+             (int)key.len, key.ptr, (int)value.len, value.ptr);
+    return ESP_OK;
+}
+
+/**
+ * @brief 解析缓冲区中的INI文本，配置项以视图形式指向缓冲区
+ * @param borrowed true表示缓冲区为外部只读内存（如flash中的rodata），字符串不以'\0'结尾；
+ *                 false表示缓冲区位于arena中，解析时就地写入'\0'，容量至少为len + 1
+ */
+static esp_err_t parse_buffer(ini_config_t* config, const char* buf, size_t len, bool borrowed) {
+    const char* pos = buf;
+    const char* buf_end = buf + len;
+    ini_str_view_t current_section = { .ptr = "", .len = 0 };
+    ini_line_mode_t mode = borrowed ? INI_LINE_BORROWED : INI_LINE_IN_PLACE;
+    
+    while (pos < buf_end) {
+        const char* line_end = memchr(pos, '\n', buf_end - pos);
+        if (!line_end) {
+            line_end = buf_end;
+        }
+        
+        esp_err_t ret = parse_line(config, pos, line_end, &current_section, mode);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        pos = line_end < buf_end ? line_end + 1 : buf_end;
+    }
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief 校验文件末尾的CRC32校验行
+ * @param required true时没有校验行也视为校验失败。截断通常正好切掉最后的校验行，
+ *                 只有要求校验行时才能发现截断
+ * @return ESP_OK校验通过，或不要求校验行且没有校验行（手工编辑或旧版本保存的文件）；
+ *         ESP_ERR_INVALID_CRC校验失败或缺少要求的校验行
+ */
+static esp_err_t verify_crc_trailer(const char* buf, size_t len, bool required) {
+    // 校验行必须是最后一行，向前找到它的行首
+    size_t end = len;
+    while (end > 0 && is_space(buf[end - 1])) {
+        end--;
+    }
+    size_t line_start = end;
+    while (line_start > 0 && buf[line_start - 1] != '\n') {
+        line_start--;
+    }
+    
+    size_t prefix_len = sizeof(INI_CRC_TRAILER_PREFIX) - 1;
+    if (end - line_start != prefix_len + 8 ||
+        memcmp(buf + line_start, INI_CRC_TRAILER_PREFIX, prefix_len) != 0) {
+        if (required) {
+            return ESP_ERR_INVALID_CRC;
+        }
+        ESP_LOGD(TAG, "No checksum trailer, skipping verification");
+        return ESP_OK;
+    }
+    
+    char hex[9];
+    memcpy(hex, buf + line_start + prefix_len, 8);
+    hex[8] = '\0';
+    char* hex_end = NULL;
+    uint32_t expected = strtoul(hex, &hex_end, 16);
+    if (hex_end != hex + 8) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    
+    uint32_t actual = esp_rom_crc32_le(0, (const uint8_t*)buf, line_start);
+    return actual == expected ? ESP_OK : ESP_ERR_INVALID_CRC;
+}
+
+/**
+ * @brief 清空已加载的配置项
+ */
+static void clear_items(ini_config_t* config) {
+    config->item_count = 0;
+    if (config->index) {
+        memset(config->index, 0xFF, config->index_size * sizeof(int32_t));
+    }
+    arena_reset(config);
+}
+
+/**
+ * @brief 获取以'\0'结尾的值，借用的值在第一次访问时复制到arena
+ */
+static const char* entry_value_cstr(ini_config_t* config, ini_entry_t* entry) {
+    if (entry->flags & INI_ENTRY_VALUE_BORROWED) {
+        if (!arena_copy_view(config, &entry->item.value)) {
+            return NULL;
+        }
+        entry->flags &= ~INI_ENTRY_VALUE_BORROWED;
+    }
+    return entry->item.value.ptr;
 }
 
 ini_config_t* ini_config_create(void) {
-    ini_config_t* config = (ini_config_t*)heap_caps_malloc(sizeof(ini_config_t), MALLOC_CAP_8BIT);
+    return ini_config_create_with_flags(INI_CONFIG_FLAG_NONE);
+}
+
+ini_config_t* ini_config_create_with_flags(uint32_t flags) {
+    ini_config_t* config = (ini_config_t*)heap_caps_calloc(1, sizeof(ini_config_t), MALLOC_CAP_8BIT);
     if (!config) {
         ESP_LOGE(TAG, "Failed to allocate memory for ini_config");
         return NULL;
     }
     
-    config->item_count = 0;
-    memset(config->items, 0, sizeof(config->items));
+    config->caps = (flags & INI_CONFIG_FLAG_PSRAM) ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT;
     
-    ESP_LOGI(TAG, "INI config created successfully");
+    ESP_LOGI(TAG, "INI config created successfully%s", (flags & INI_CONFIG_FLAG_PSRAM) ? " (PSRAM)" : "");
     return config;
 }
 
 void ini_config_destroy(ini_config_t* config) {
     if (config) {
+        arena_reset(config);
+        free(config->entries);
+        free(config->index);
         free(config);
         ESP_LOGI(TAG, "INI config destroyed");
     }
 }
 
-esp_err_t ini_config_load_from_file(ini_config_t* config, const char* filename) {
+/**
+ * @brief 从文件加载INI配置
+ * @param require_trailer true时没有校验行的文件按校验失败处理
+ */
+static esp_err_t load_file(ini_config_t* config, const char* filename, bool require_trailer) {
     if (!config || !filename) {
         return ESP_ERR_INVALID_ARG;
     }
@@ -128,124 +768,308 @@ esp_err_t ini_config_load_from_file(ini_config_t* config, const char* filename)
         return ESP_ERR_NOT_FOUND;
     }
     
-    char line[INI_MAX_LINE_LENGTH];
-    char current_section[INI_MAX_SECTION_NAME] = "";
-    char key[INI_MAX_KEY_NAME];
-    char value[INI_MAX_VALUE_LENGTH];
+    // 获取文件大小，arena按文件大小一次分配
+    long file_size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        file_size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+    }
+    if (file_size < 0) {
+        fclose(file);
+        ESP_LOGE(TAG, "Failed to get size of file: %s", filename);
+        return ESP_FAIL;
+    }
     
-    config->item_count = 0;
+    clear_items(config);
     
-    while (fgets(line, sizeof(line), file) && config->item_count < MAX_INI_ITEMS) {
-        char* trimmed_line = trim_whitespace(line);
-        
-        // 跳过空行和注释行
-        if (strlen(trimmed_line) == 0 || trimmed_line[0] == '#' || trimmed_line[0] == ';') {
-            continue;
-        }
-        
-        // 检查是否为段名
-        if (is_section_line(trimmed_line, current_section)) {
-            ESP_LOGD(TAG, "Found section: [%s]", current_section);
-            continue;
-        }
-        
-        // 解析键值对
-        if (parse_key_value(trimmed_line, key, value)) {
-            strcpy(config->items[config->item_count].section, current_section);
-            strcpy(config->items[config->item_count].key, key);
-            strcpy(config->items[config->item_count].value, value);
-            config->item_count++;
-            
-            ESP_LOGD(TAG, "Loaded: [%s] %s = %s", current_section, key, value);
-        }
+    // 文件内容直接读入arena，解析时就地切分字符串
+    char* buf = arena_alloc(config, (size_t)file_size + 1, 0);
+    if (!buf) {
+        fclose(file);
+        return ESP_ERR_NO_MEM;
     }
     
+    size_t read_len = fread(buf, 1, (size_t)file_size, file);
     fclose(file);
-    ESP_LOGI(TAG, "Loaded %d items from %s", config->item_count, filename);
+    buf[read_len] = '\0';
+    
+    esp_err_t ret = verify_crc_trailer(buf, read_len, require_trailer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Checksum missing or mismatched in %s, file is truncated or corrupted", filename);
+        clear_items(config);
+        return ret;
+    }
+    
+    ret = parse_buffer(config, buf, read_len, false);
+    if (ret != ESP_OK) {
+        clear_items(config);
+        return ret;
+    }
+    
+    apply_specs(config);
+    ESP_LOGI(TAG, "Loaded %d items from %s (%d bytes)", config->item_count, filename, (int)read_len);
     return ESP_OK;
 }
 
+esp_err_t ini_config_load_from_file(ini_config_t* config, const char* filename) {
+    return load_file(config, filename, false);
+}
+
+esp_err_t ini_config_load_from_file_verified(ini_config_t* config, const char* filename) {
+    return load_file(config, filename, true);
+}
+
 esp_err_t ini_config_load_from_string(ini_config_t* config, const char* ini_string) {
     if (!config || !ini_string) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    char* str_copy = strdup(ini_string);
-    if (!str_copy) {
+    clear_items(config);
+    
+    size_t len = strlen(ini_string);
+    char* buf = arena_alloc(config, len + 1, 0);
+    if (!buf) {
         return ESP_ERR_NO_MEM;
     }
+    memcpy(buf, ini_string, len + 1);
     
-    char current_section[INI_MAX_SECTION_NAME] = "";
-    char key[INI_MAX_KEY_NAME];
-    char value[INI_MAX_VALUE_LENGTH];
+    esp_err_t ret = parse_buffer(config, buf, len, false);
+    if (ret != ESP_OK) {
+        clear_items(config);
+        return ret;
+    }
     
-    config->item_count = 0;
+    apply_specs(config);
+    ESP_LOGI(TAG, "Loaded %d items from string", config->item_count);
+    return ESP_OK;
+}
+
+esp_err_t ini_config_load_from_rodata(ini_config_t* config, const char* data, size_t len) {
+    if (!config || !data) {
+        return ESP_ERR_INVALID_ARG;
+    }
     
-    char* line = strtok(str_copy, "\n\r");
-    while (line && config->item_count < MAX_INI_ITEMS) {
-        char* trimmed_line = trim_whitespace(line);
-        
-        // 跳过空行和注释行
-        if (strlen(trimmed_line) == 0 || trimmed_line[0] == '#' || trimmed_line[0] == ';') {
-            line = strtok(NULL, "\n\r");
-            continue;
+    clear_items(config);
+    
+    esp_err_t ret = parse_buffer(config, data, len, true);
+    if (ret != ESP_OK) {
+        clear_items(config);
+        return ret;
+    }
+    
+    apply_specs(config);
+    ESP_LOGI(TAG, "Loaded %d items in place from %d bytes of read-only data", config->item_count, (int)len);
+    return ESP_OK;
+}
+
+ini_parser_t* ini_parser_create(ini_config_t* config) {
+    if (!config) {
+        return NULL;
+    }
+    
+    ini_parser_t* parser = (ini_parser_t*)heap_caps_calloc(1, sizeof(ini_parser_t), MALLOC_CAP_8BIT);
+    if (!parser) {
+        ESP_LOGE(TAG, "Failed to allocate memory for ini_parser");
+        return NULL;
+    }
+    
+    clear_items(config);
+    parser->config = config;
+    parser->section.ptr = "";
+    return parser;
+}
+
+/**
+ * @brief 将数据追加到未完成行缓冲区，容量按倍数增长
+ */
+static esp_err_t parser_buffer_line(ini_parser_t* parser, const char* data, size_t len) {
+    if (parser->line_len + len > parser->line_capacity) {
+        size_t capacity = parser->line_capacity ? parser->line_capacity : 128;
+        while (capacity < parser->line_len + len) {
+            capacity *= 2;
         }
-        
-        // 检查是否为段名
-        if (is_section_line(trimmed_line, current_section)) {
-            line = strtok(NULL, "\n\r");
-            continue;
+        char* line = (char*)realloc(parser->line, capacity);
+        if (!line) {
+            ESP_LOGE(TAG, "Failed to grow line buffer to %d bytes", (int)capacity);
+            return ESP_ERR_NO_MEM;
         }
-        
-        // 解析键值对
-        if (parse_key_value(trimmed_line, key, value)) {
-            strcpy(config->items[config->item_count].section, current_section);
-            strcpy(config->items[config->item_count].key, key);
-            strcpy(config->items[config->item_count].value, value);
-            config->item_count++;
+        parser->line = line;
+        parser->line_capacity = capacity;
+    }
+    
+    memcpy(parser->line + parser->line_len, data, len);
+    parser->line_len += len;
+    return ESP_OK;
+}
+
+/**
+ * @brief 记录解析错误并丢弃已解析的配置项
+ */
+static esp_err_t parser_fail(ini_parser_t* parser, esp_err_t err) {
+    parser->error = err;
+    clear_items(parser->config);
+    return err;
+}
+
+esp_err_t ini_parser_feed(ini_parser_t* parser, const char* chunk, size_t len) {
+    if (!parser || (!chunk && len)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (parser->error != ESP_OK) {
+        return parser->error;
+    }
+    
+    const char* pos = chunk;
+    const char* chunk_end = chunk + len;
+    esp_err_t ret;
+    
+    while (pos < chunk_end) {
+        const char* line_end = memchr(pos, '\n', chunk_end - pos);
+        if (!line_end) {
+            // 行不完整，留到下一个数据块
+            ret = parser_buffer_line(parser, pos, chunk_end - pos);
+            return ret == ESP_OK ? ESP_OK : parser_fail(parser, ret);
         }
         
-        line = strtok(NULL, "\n\r");
+        if (parser->line_len > 0) {
+            // 拼接上一个数据块留下的行首
+            ret = parser_buffer_line(parser, pos, line_end - pos);
+            if (ret == ESP_OK) {
+                ret = parse_line(parser->config, parser->line, parser->line + parser->line_len,
+                                 &parser->section, INI_LINE_COPY);
+            }
+            parser->line_len = 0;
+        } else {
+            // 完整的行直接在数据块中解析，不经过行缓冲区
+            ret = parse_line(parser->config, pos, line_end, &parser->section, INI_LINE_COPY);
+        }
+        if (ret != ESP_OK) {
+            return parser_fail(parser, ret);
+        }
+        pos = line_end + 1;
     }
     
-    free(str_copy);
-    ESP_LOGI(TAG, "Loaded %d items from string", config->item_count);
     return ESP_OK;
 }
 
+esp_err_t ini_parser_finish(ini_parser_t* parser) {
+    if (!parser) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (parser->error != ESP_OK) {
+        return parser->error;
+    }
+    
+    // 最后一行可能没有换行符
+    if (parser->line_len > 0) {
+        esp_err_t ret = parse_line(parser->config, parser->line, parser->line + parser->line_len,
+                                   &parser->section, INI_LINE_COPY);
+        parser->line_len = 0;
+        if (ret != ESP_OK) {
+            return parser_fail(parser, ret);
+        }
+    }
+    
+    apply_specs(parser->config);
+    ESP_LOGI(TAG, "Loaded %d items from stream", parser->config->item_count);
+    return ESP_OK;
+}
+
+void ini_parser_destroy(ini_parser_t* parser) {
+    if (parser) {
+        free(parser->line);
+        free(parser);
+    }
+}
+
 esp_err_t ini_config_save_to_file(ini_config_t* config, const char* filename) {
     if (!config || !filename) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    FILE* file = fopen(filename, "w");
-    if (!file) {
-        ESP_LOGE(TAG, "Failed to open file for writing: %s", filename);
-        return ESP_ERR_NOT_FOUND;
+    // 先计算渲染后的总长度，整个文件在内存中一次渲染完成
+    static const char header[] = "# XJ1Core 配置文件\n# 编码: UTF-8\n\n";
+    size_t total = sizeof(header) - 1 + sizeof(INI_CRC_TRAILER_PREFIX) - 1 + 8 + 1;
+    for (int i = 0; i < config->item_count; i++) {
+        const ini_item_t* item = &config->entries[i].item;
+        // 段名行"[section]\n"和段前空行按最坏情况计算
+        total += item->section.len + 4 + item->key.len + item->value.len + 2;
+    }
+    
+    char* buf = config_alloc(config, total + 1);
+    if (!buf) {
+        ESP_LOGE(TAG, "Failed to allocate %d bytes to render %s", (int)total, filename);
+        return ESP_ERR_NO_MEM;
     }
     
-    // 写入UTF-8 BOM和头注释
-    fprintf(file, "# XJ1Core 配置文件\n");
-    fprintf(file, "# 编码: UTF-8\n\n");
+    char* out = buf;
+    memcpy(out, header, sizeof(header) - 1);
+    out += sizeof(header) - 1;
     
-    char current_section[INI_MAX_SECTION_NAME] = "";
+    const ini_str_view_t* current_section = NULL;
     
     for (int i = 0; i < config->item_count; i++) {
+        const ini_item_t* item = &config->entries[i].item;
+        
         // 如果段名发生变化，写入新段名
-        if (strcmp(current_section, config->items[i].section) != 0) {
-            if (strlen(current_section) > 0) {
-                fprintf(file, "\n");  // 段之间空行
+        if (!current_section || !view_equals(*current_section, item->section)) {
+            if (current_section) {
+                *out++ = '\n';  // 段之间空行
             }
-            strcpy(current_section, config->items[i].section);
-            fprintf(file, "[%s]\n", current_section);
+            current_section = &item->section;
+            *out++ = '[';
+            memcpy(out, current_section->ptr, current_section->len);
+            out += current_section->len;
+            *out++ = ']';
+            *out++ = '\n';
         }
         
         // 写入键值对
-        fprintf(file, "%s=%s\n", config->items[i].key, config->items[i].value);
+        memcpy(out, item->key.ptr, item->key.len);
+        out += item->key.len;
+        *out++ = '=';
+        memcpy(out, item->value.ptr, item->value.len);
+        out += item->value.len;
+        *out++ = '\n';
+    }
+    
+    // 末尾追加校验行，加载时据此发现损坏的文件；ini_config_load_from_file_verified还要求
+    // 校验行存在，才能发现正好截掉校验行的文件
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)buf, out - buf);
+    out += snprintf(out, total + 1 - (out - buf), INI_CRC_TRAILER_PREFIX "%08" PRIx32 "\n", crc);
+    size_t len = out - buf;
+    
+    // 写入临时文件并刷到flash，完整写入后再替换正式文件
+    char tmp_path[64];
+    snprintf(tmp_path, sizeof(tmp_path), "%s" INI_SAVE_TMP_SUFFIX, filename);
+    
+    FILE* file = fopen(tmp_path, "wb");
+    if (!file) {
+        free(buf);
+        ESP_LOGE(TAG, "Failed to open file for writing: %s", tmp_path);
+        return ESP_ERR_NOT_FOUND;
     }
     
+    size_t written = fwrite(buf, 1, len, file);
+    bool flushed = fflush(file) == 0 && fsync(fileno(file)) == 0;
     fclose(file);
-    ESP_LOGI(TAG, "Saved %d items to %s", config->item_count, filename);
+    free(buf);
+    
+    if (written != len || !flushed) {
+        ESP_LOGE(TAG, "Failed to write %s (wrote %d of %d bytes)", tmp_path, (int)written, (int)len);
+        unlink(tmp_path);
+        return ESP_FAIL;
+    }
+    
+    // SPIFFS的rename不能覆盖已存在的文件，需要先删除旧文件；
+    // 若在两步之间断电，下次启动时由调用者从临时文件恢复
+    unlink(filename);
+    if (rename(tmp_path, filename) != 0) {
+        ESP_LOGE(TAG, "Failed to rename %s to %s", tmp_path, filename);
+        return ESP_FAIL;
+    }
+    
+    ESP_LOGI(TAG, "Saved %d items to %s (%d bytes)", config->item_count, filename, (int)len);
     return ESP_OK;
 }
 
@@ -254,23 +1078,89 @@ const char* ini_config_get_string(ini_config_t* config, const char* section, con
         return default_value;
     }
     
-    for (int i = 0; i < config->item_count; i++) {
-        if (strcmp(config->items[i].section, section) == 0 && 
-            strcmp(config->items[i].key, key) == 0) {
-            return config->items[i].value;
-        }
+    int i = find_item(config, section, key);
+    if (i < 0) {
+        return default_value;
+    }
+    
+    const char* value = entry_value_cstr(config, &config->entries[i]);
+    return value ? value : default_value;
+}
+
+bool ini_config_get_view(ini_config_t* config, const char* section, const char* key, ini_str_view_t* value) {
+    if (!config || !section || !key || !value) {
+        return false;
+    }
+    
+    int i = find_item(config, section, key);
+    if (i < 0) {
+        return false;
+    }
+    
+    *value = config->entries[i].item.value;
+    return true;
+}
+
+esp_err_t ini_config_copy_string(ini_config_t* config, const char* section, const char* key,
+                                 char* buffer, size_t buffer_size, const char* default_value) {
+    if (!buffer || buffer_size == 0) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    return default_value;
+    ini_str_view_t value;
+    if (!ini_config_get_view(config, section, key, &value)) {
+        value = make_view(default_value ? default_value : "");
+    }
+    
+    size_t copy_len = value.len < buffer_size ? value.len : buffer_size - 1;
+    memcpy(buffer, value.ptr, copy_len);
+    buffer[copy_len] = '\0';
+    
+    if (copy_len < value.len) {
+        ESP_LOGW(TAG, "[%s] %s truncated to %d bytes", section, key, (int)copy_len);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 查找配置项
+ */
+static ini_entry_t* get_entry(ini_config_t* config, const char* section, const char* key) {
+    if (!config || !section || !key) {
+        return NULL;
+    }
+    int i = find_item(config, section, key);
+    return i >= 0 ? &config->entries[i] : NULL;
 }
 
 int ini_config_get_int(ini_config_t* config, const char* section, const char* key, int default_value) {
-    const char* str_value = ini_config_get_string(config, section, key, NULL);
-    if (!str_value) {
-        return default_value;
+    const ini_entry_t* entry = get_entry(config, section, key);
+    return entry && (entry->typed & INI_TYPED_INT) ? entry->int_value : default_value;
+}
+
+bool ini_config_get_bool(ini_config_t* config, const char* section, const char* key, bool default_value) {
+    const ini_entry_t* entry = get_entry(config, section, key);
+    return entry && (entry->typed & INI_TYPED_BOOL) ? entry->bool_value : default_value;
+}
+
+float ini_config_get_float(ini_config_t* config, const char* section, const char* key, float default_value) {
+    const ini_entry_t* entry = get_entry(config, section, key);
+    return entry && (entry->typed & INI_TYPED_FLOAT) ? entry->float_value : default_value;
+}
+
+esp_err_t ini_config_declare(ini_config_t* config, const ini_value_spec_t* specs, size_t count) {
+    if (!config || (!specs && count)) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    return atoi(str_value);
+    config->specs = specs;
+    config->spec_count = count;
+    for (int i = 0; i < config->item_count; i++) {
+        config->entries[i].spec = NULL;
+    }
+    apply_specs(config);
+    return ESP_OK;
 }
 
 esp_err_t ini_config_set_string(ini_config_t* config, const char* section, const char* key, const char* value) {
@@ -278,33 +1168,62 @@ esp_err_t ini_config_set_string(ini_config_t* config, const char* section, const
         return ESP_ERR_INVALID_ARG;
     }
     
+    ini_str_view_t new_value = make_view(value);
+    
     // 检查是否已存在，如果存在则更新
-    for (int i = 0; i < config->item_count; i++) {
-        if (strcmp(config->items[i].section, section) == 0 && 
-            strcmp(config->items[i].key, key) == 0) {
-            strncpy(config->items[i].value, value, INI_MAX_VALUE_LENGTH - 1);
-            config->items[i].value[INI_MAX_VALUE_LENGTH - 1] = '\0';
+    int i = find_item(config, section, key);
+    if (i >= 0) {
+        ini_entry_t* entry = &config->entries[i];
+        if (view_equals(entry->item.value, new_value)) {
             return ESP_OK;
         }
-    }
-    
-    // 如果不存在且还有空间，则添加新项
-    if (config->item_count < MAX_INI_ITEMS) {
-        strncpy(config->items[config->item_count].section, section, INI_MAX_SECTION_NAME - 1);
-        config->items[config->item_count].section[INI_MAX_SECTION_NAME - 1] = '\0';
         
-        strncpy(config->items[config->item_count].key, key, INI_MAX_KEY_NAME - 1);
-        config->items[config->item_count].key[INI_MAX_KEY_NAME - 1] = '\0';
+        // arena中的旧值且新值不长于旧值时直接覆盖，否则在arena中追加
+        if (!(entry->flags & INI_ENTRY_VALUE_BORROWED) && new_value.len <= entry->item.value.len) {
+            memcpy((char*)entry->item.value.ptr, value, new_value.len + 1);
+            config->arena_waste += entry->item.value.len - new_value.len;
+            entry->item.value.len = new_value.len;
+        } else {
+            if (!arena_copy_view(config, &new_value)) {
+                return ESP_ERR_NO_MEM;
+            }
+            if (!(entry->flags & INI_ENTRY_VALUE_BORROWED)) {
+                config->arena_waste += entry->item.value.len + 1;
+            }
+            entry->item.value = new_value;
+            entry->flags &= ~INI_ENTRY_VALUE_BORROWED;
+        }
         
-        strncpy(config->items[config->item_count].value, value, INI_MAX_VALUE_LENGTH - 1);
-        config->items[config->item_count].value[INI_MAX_VALUE_LENGTH - 1] = '\0';
+        entry_parse_typed(entry);
+        if (entry->spec) {
+            entry_apply_spec(entry);
+        }
         
-        config->item_count++;
+        if (config->arena_waste > INI_ARENA_COMPACT_MIN && config->arena_waste * 2 > config->arena_used) {
+            arena_compact(config);
+        }
         return ESP_OK;
     }
     
-    ESP_LOGE(TAG, "INI config is full, cannot add more items");
-    return ESP_ERR_NO_MEM;
+    // 不存在则添加新项，数量不再有上限
+    ini_str_view_t section_view = make_view(section);
+    ini_str_view_t key_view = make_view(key);
+    if (!intern_section(config, &section_view) ||
+        !arena_copy_view(config, &key_view) ||
+        !arena_copy_view(config, &new_value)) {
+        ESP_LOGE(TAG, "Out of memory adding [%s] %s", section, key);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    esp_err_t ret = append_item(config, section_view, key_view, new_value, 0);
+    if (ret == ESP_OK) {
+        ini_entry_t* entry = &config->entries[config->item_count - 1];
+        entry->spec = lookup_spec(config, section, key);
+        if (entry->spec) {
+            entry_apply_spec(entry);
+        }
+    }
+    return ret;
 }
 
 esp_err_t ini_config_set_int(ini_config_t* config, const char* section, const char* key, int value) {
@@ -318,12 +1237,94 @@ bool ini_config_has_key(ini_config_t* config, const char* section, const char* k
         return false;
     }
     
+    return find_item(config, section, key) >= 0;
+}
+
+/**
+ * @brief 统计被删除配置项在arena中不再引用的字节数
+ * @note 段名可能被其他项共享，只统计键名和值
+ */
+static void account_removed_entry(ini_config_t* config, const ini_entry_t* entry) {
+    if (!(entry->flags & INI_ENTRY_NAMES_BORROWED)) {
+        config->arena_waste += entry->item.key.len + 1;
+    }
+    if (!(entry->flags & INI_ENTRY_VALUE_BORROWED)) {
+        config->arena_waste += entry->item.value.len + 1;
+    }
+}
+
+/**
+ * @brief 删除配置项后重建索引，必要时整理arena
+ */
+static void finish_removal(ini_config_t* config, int kept) {
+    config->item_count = kept;
+    rebuild_index(config);
+    
+    if (config->arena_waste > INI_ARENA_COMPACT_MIN && config->arena_waste * 2 > config->arena_used) {
+        arena_compact(config);
+    }
+}
+
+esp_err_t ini_config_remove_key(ini_config_t* config, const char* section, const char* key) {
+    if (!config || !section || !key) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (find_item(config, section, key) < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    // 保持其余配置项的顺序，保存时文件内容只少这一行；重复出现的同名键一并删除
+    ini_str_view_t section_view = make_view(section);
+    ini_str_view_t key_view = make_view(key);
+    int kept = 0;
     for (int i = 0; i < config->item_count; i++) {
-        if (strcmp(config->items[i].section, section) == 0 && 
-            strcmp(config->items[i].key, key) == 0) {
-            return true;
+        ini_entry_t* entry = &config->entries[i];
+        if (view_equals(entry->item.section, section_view) && view_equals(entry->item.key, key_view)) {
+            account_removed_entry(config, entry);
+            continue;
         }
+        if (kept != i) {
+            config->entries[kept] = *entry;
+        }
+        kept++;
+    }
+    finish_removal(config, kept);
+    return ESP_OK;
+}
+
+int ini_config_remove_equal(ini_config_t* config, const ini_config_t* other) {
+    if (!config || !other) {
+        return 0;
     }
     
-    return false;
+    int kept = 0;
+    for (int i = 0; i < config->item_count; i++) {
+        ini_entry_t* entry = &config->entries[i];
+        int j = find_entry(other, entry->item.section, entry->item.key);
+        if (j >= 0 && view_equals(other->entries[j].item.value, entry->item.value)) {
+            account_removed_entry(config, entry);
+            continue;
+        }
+        if (kept != i) {
+            config->entries[kept] = *entry;
+        }
+        kept++;
+    }
+    
+    int removed = config->item_count - kept;
+    if (removed > 0) {
+        finish_removal(config, kept);
+    }
+    return removed;
+}
+
+void ini_config_clear(ini_config_t* config) {
+    if (config) {
+        clear_items(config);
+    }
+}
+
+int ini_config_get_item_count(const ini_config_t* config) {
+    return config ? config->item_count : 0;
 }
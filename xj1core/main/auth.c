@@ -22,14 +22,291 @@
 #include "esp_log.h"
 #include "esp_random.h"
 #include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_attr.h"
+#include "esp_rtc_time.h"
+#include "esp_rom_crc.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "mbedtls/sha256.h"
+#include "mbedtls/md.h"
+#include "mbedtls/pkcs5.h"
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#define SESSION_INDEX_EMPTY 0xFFFF
+
+#define AUTH_NVS_NAMESPACE "xj1_auth"
+#define AUTH_NVS_SESSIONS_KEY "sessions"
+#define SESSION_IMAGE_MAGIC 0x53414A58      // "XJAS"
+#define SESSION_IMAGE_VERSION 1             // session_image_t含义变化时必须加1
+#define AUTH_NVS_API_KEYS_KEY "api_keys"
+#define API_KEY_IMAGE_MAGIC 0x4B414A58      // "XJAK"
+#define API_KEY_IMAGE_VERSION 1
+
+/**
+ * @brief 会话记录，会话ID以二进制保存
+ * @note API密钥与会话共用会话表，id为密钥的SHA-256摘要，username为密钥名称；
+ *       API密钥不挂在时间轮上，不会过期，也不写入会话镜像
+ */
+typedef struct {
+    uint8_t id[AUTH_SESSION_ID_BYTES];
+    char username[32];
+    uint64_t created_time;
+    uint64_t last_access_time;
+    uint32_t expire_tick;               // 挂在时间轮上的到期刻度
+    uint16_t wheel_prev;                // 同一时间轮槽中前后会话的下标
+    uint16_t wheel_next;
+    bool api_key;
+} session_entry_t;
 
 static const char *TAG = "auth";
-static auth_session_t g_sessions[AUTH_MAX_SESSIONS];
 static bool g_auth_initialized = false;
 
+/*
+ * 会话表：有效会话紧凑排列在g_sessions前g_session_count项，g_session_index是以会话ID
+ * 为键的开放寻址哈希表（线性探测，装载率不超过1/2），保存会话在g_sessions中的下标。
+ * 查找、创建和删除都是O(1)。会话表在httpd任务和esp_timer任务中访问，由g_session_mutex保护。
+ * 表中另有最多AUTH_MAX_API_KEYS项API密钥，g_api_key_count不计入max_sessions限制
+ */
+static session_entry_t* g_sessions = NULL;
+static uint16_t* g_session_index = NULL;
+static uint32_t g_index_mask = 0;
+static int g_max_sessions = 0;
+static int g_session_count = 0;
+static int g_api_key_count = 0;
+static SemaphoreHandle_t g_session_mutex = NULL;
+
+/*
+ * 过期时间轮：会话按到期刻度挂在g_wheel[刻度 % 槽数]的双向链表上，esp_timer每个刻度推进一次，
+ * 只检查到期槽中的会话。访问会话只更新last_access_time，不移动节点；检查时发现会话期间被访问过，
+ * 再按新的到期刻度重新挂载，所以每次推进的开销只与到期槽中的会话数有关，与会话总数无关
+ */
+static uint16_t g_wheel[AUTH_SESSION_WHEEL_SLOTS];
+static uint32_t g_wheel_tick = 0;       // 已推进到的刻度
+static esp_timer_handle_t g_wheel_timer = NULL;
+static bool g_wheel_running = false;    // 有会话时定时器才运行
+
+// 会话超时(ms)，取自timeouts.session_max_age，配置修改后立即生效
+static volatile uint32_t g_session_timeout_ms = AUTH_SESSION_TIMEOUT_DEFAULT_MS;
+
+/**
+ * @brief 令牌签名密钥
+ */
+typedef struct {
+    uint8_t key[32];
+    uint32_t generation;
+} token_key_t;
+
+/*
+ * 无状态令牌：密钥在启动时随机生成，只保存在内存中，重启后此前的令牌全部失效。
+ * 每个会话超时周期轮换一次并保留上一代密钥，轮换前签发且未过期的令牌仍然有效
+ */
+static bool g_token_mode = false;
+static token_key_t g_token_keys[2];     // [0]当前密钥，[1]上一代密钥，受g_session_mutex保护
+static uint64_t g_token_key_time = 0;   // 当前密钥生成时间(ms)
+static char g_token_username[32];       // 令牌绑定的账号，由配置变化回调更新，受g_session_mutex保护
+
+/**
+ * @brief 登录限速记录
+ */
+typedef struct {
+    uint8_t addr[AUTH_CLIENT_ADDR_BYTES];
+    bool in_use;
+    uint8_t failures;                   // 连续失败次数
+    uint16_t tokens_milli;              // 剩余尝试机会，单位为千分之一次
+    uint64_t refill_time;               // 上次补充尝试机会的时间(ms)
+    uint64_t locked_until;              // 锁定结束时间(ms)
+    uint64_t last_seen;                 // 最近一次出现的时间(ms)
+} throttle_entry_t;
+
+// 只在httpd任务中访问，不加锁
+static throttle_entry_t g_throttle[AUTH_THROTTLE_CLIENTS];
+
+/*
+ * 认证时钟(ms)：esp_timer加上g_clock_offset_ms。恢复会话时把偏移设为保存时的时钟加上重启耗时，
+ * 会话时间和令牌签发时间在重启后继续有效，不需要换算
+ */
+static uint64_t g_clock_offset_ms = 0;
+
+/**
+ * @brief 重启后恢复的会话
+ */
+typedef struct {
+    uint8_t id[AUTH_SESSION_ID_BYTES];
+    uint64_t created_time;
+    uint64_t last_access_time;
+} persisted_session_t;
+
+/**
+ * @brief 重启后恢复会话用的紧凑镜像，同一格式保存在RTC_NOINIT内存和NVS中
+ * @note 只保存最近访问的AUTH_PERSIST_MAX_SESSIONS个会话，写入和校验只覆盖前count项；
+ *       会话ID和令牌密钥以明文保存，需要防止读取flash时应启用NVS加密
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;                         // 有效会话数
+    uint32_t crc;                           // 计算时本字段取0，覆盖到最后一个有效会话
+    uint64_t clock_ms;                      // 保存时的认证时钟
+    uint64_t rtc_us;                        // 保存时的RTC时间，软件重启后用来计算重启耗时
+    char username[32];                      // 会话所属账号，账号改名后不恢复
+    token_key_t token_keys[2];
+    uint64_t token_key_time;
+    persisted_session_t sessions[AUTH_PERSIST_MAX_SESSIONS];
+} session_image_t;
+
+/*
+ * RTC内存中的镜像在会话增删时立即更新，访问时间在时间轮推进时更新，软件重启后完整恢复；
+ * NVS中的镜像按写入预算由auth_save_sessions写入，只用于断电重启
+ */
+static RTC_NOINIT_ATTR session_image_t s_rtc_sessions;
+static bool g_persist_enabled = false;
+static bool g_rtc_touch_pending = false;    // 有访问时间尚未更新到RTC镜像
+static bool g_nvs_members_dirty = false;    // 登录、过期或密钥轮换后尚未写入NVS
+static bool g_nvs_touch_dirty = false;      // 访问时间变化后尚未写入NVS
+static uint64_t g_nvs_save_time = 0;        // 上次写入NVS的认证时钟
+
+/**
+ * @brief 保存在NVS中的API密钥，只有摘要，没有密钥本身
+ */
+typedef struct {
+    uint8_t digest[AUTH_SESSION_ID_BYTES];
+    char name[AUTH_API_KEY_NAME_MAX + 1];
+} persisted_api_key_t;
+
+/**
+ * @brief API密钥镜像，创建和吊销时立即写入NVS，与persist_sessions无关
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t crc;                           // 计算时本字段取0，覆盖整个镜像
+    persisted_api_key_t keys[AUTH_MAX_API_KEYS];
+} api_key_image_t;
+
+static uint32_t find_index_pos(const uint8_t* id);
+static esp_err_t save_session_image(bool force);
+static void load_api_keys(void);
+static bool validate_api_key(const char* api_key);
+
+/**
+ * @brief 当前认证时钟(ms)
+ */
+static inline uint64_t auth_now_ms(void) {
+    return esp_timer_get_time() / 1000 + g_clock_offset_ms;
+}
+
+/**
+ * @brief 会话镜像的有效长度
+ */
+static inline size_t session_image_size(uint16_t count) {
+    return offsetof(session_image_t, sessions) + count * sizeof(persisted_session_t);
+}
+
+/**
+ * @brief 计算会话镜像的CRC32，crc字段按0计算
+ */
+static uint32_t session_image_crc(session_image_t* image) {
+    uint32_t saved = image->crc;
+    image->crc = 0;
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)image, session_image_size(image->count));
+    image->crc = saved;
+    return crc;
+}
+
+/**
+ * @brief 检查会话镜像的格式和校验
+ * @param length 镜像的实际长度
+ */
+static bool session_image_valid(session_image_t* image, size_t length) {
+    return length >= offsetof(session_image_t, sessions) && image->magic == SESSION_IMAGE_MAGIC &&
+           image->version == SESSION_IMAGE_VERSION && image->count <= AUTH_PERSIST_MAX_SESSIONS &&
+           length == session_image_size(image->count) && image->crc == session_image_crc(image);
+}
+
+/**
+ * @brief 把当前会话和令牌密钥写成镜像
+ * @note 调用者持有g_session_mutex。会话数超过AUTH_PERSIST_MAX_SESSIONS时保留最近访问的，
+ *       只保存与最近访问的会话属于同一账号的会话
+ */
+static void build_session_image(session_image_t* image, uint64_t now) {
+    memset(image, 0, sizeof(session_image_t));
+    image->magic = SESSION_IMAGE_MAGIC;
+    image->version = SESSION_IMAGE_VERSION;
+    image->clock_ms = now;
+    image->rtc_us = esp_rtc_get_time_us();
+    memcpy(image->token_keys, g_token_keys, sizeof(image->token_keys));
+    image->token_key_time = g_token_key_time;
+    
+    // 按最后访问时间从新到旧插入，超出容量的旧会话丢弃
+    int count = 0;
+    for (int i = 0; i < g_session_count; i++) {
+        const session_entry_t* session = &g_sessions[i];
+        if (session->api_key) {
+            continue;
+        }
+        int pos = count;
+        while (pos > 0 && image->sessions[pos - 1].last_access_time < session->last_access_time) {
+            pos--;
+        }
+        if (pos >= AUTH_PERSIST_MAX_SESSIONS) {
+            continue;
+        }
+        int move = (count < AUTH_PERSIST_MAX_SESSIONS ? count : AUTH_PERSIST_MAX_SESSIONS - 1) - pos;
+        memmove(&image->sessions[pos + 1], &image->sessions[pos], move * sizeof(persisted_session_t));
+        memcpy(image->sessions[pos].id, session->id, AUTH_SESSION_ID_BYTES);
+        image->sessions[pos].created_time = session->created_time;
+        image->sessions[pos].last_access_time = session->last_access_time;
+        if (count < AUTH_PERSIST_MAX_SESSIONS) {
+            count++;
+        }
+    }
+    
+    // 镜像中的会话ID不含用户名，按最近访问的会话的账号过滤
+    if (count > 0) {
+        int slot = g_session_index[find_index_pos(image->sessions[0].id)];
+        snprintf(image->username, sizeof(image->username), "%s", g_sessions[slot].username);
+        int kept = 0;
+        for (int i = 0; i < count; i++) {
+            slot = g_session_index[find_index_pos(image->sessions[i].id)];
+            if (strcmp(g_sessions[slot].username, image->username) == 0) {
+                image->sessions[kept++] = image->sessions[i];
+            }
+        }
+        memset(&image->sessions[kept], 0, (count - kept) * sizeof(persisted_session_t));
+        count = kept;
+    }
+    
+    image->count = count;
+    image->crc = session_image_crc(image);
+}
+
+/**
+ * @brief 更新RTC内存中的镜像
+ * @note 调用者持有g_session_mutex
+ */
+static void update_rtc_image(uint64_t now) {
+    g_rtc_touch_pending = false;
+    if (g_persist_enabled) {
+        build_session_image(&s_rtc_sessions, now);
+    }
+}
+
+/**
+ * @brief 会话增删或密钥变化后更新RTC镜像，并标记等待写入NVS
+ * @note 调用者持有g_session_mutex
+ */
+static void session_table_changed(uint64_t now) {
+    g_nvs_members_dirty = true;
+    update_rtc_image(now);
+}
+
 /**
  * @brief 将字节数组转换为十六进制字符串
  */
@@ -41,32 +318,551 @@ static void bytes_to_hex_string(const uint8_t* bytes, size_t len, char* hex_stri
 }
 
 /**
- * @brief 查找空闲会话槽位
+ * @brief 解析十六进制字符串
+ * @param hex 十六进制字符串，至少len * 2个字符
+ * @param bytes 输出字节数组
+ * @param len 字节数
+ * @return true格式正确，false含非十六进制字符
  */
-static int find_free_session_slot(void) {
-    for (int i = 0; i < AUTH_MAX_SESSIONS; i++) {
-        if (!g_sessions[i].is_valid) {
-            return i;
+static bool parse_hex(const char* hex, uint8_t* bytes, size_t len) {
+    for (size_t i = 0; i < len * 2; i++) {
+        char c = hex[i];
+        uint8_t nibble;
+        if (c >= '0' && c <= '9') {
+            nibble = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            nibble = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            nibble = c - 'A' + 10;
+        } else {
+            return false;
         }
+        bytes[i / 2] = (i % 2) ? (bytes[i / 2] | nibble) : (uint8_t)(nibble << 4);
     }
-    return -1;
+    return true;
+}
+
+/**
+ * @brief 解析十六进制会话ID
+ * @return true格式正确，false长度不对或含非十六进制字符
+ */
+static bool parse_session_id(const char* session_id, uint8_t* id) {
+    return session_id && strlen(session_id) == AUTH_SESSION_ID_LENGTH &&
+           parse_hex(session_id, id, AUTH_SESSION_ID_BYTES);
+}
+
+/**
+ * @brief 判断是否为令牌格式
+ */
+static bool is_token(const char* credential) {
+    return credential && credential[0] == 't' && strlen(credential) == AUTH_TOKEN_LENGTH;
+}
+
+/**
+ * @brief 常量时间比较，耗时与第一个不同字节的位置无关
+ */
+static bool constant_time_equal(const uint8_t* a, const uint8_t* b, size_t len) {
+    uint8_t diff = 0;
+    for (size_t i = 0; i < len; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+/**
+ * @brief 会话ID在哈希表中的初始位置
+ * @note 会话ID本身是均匀随机数，直接取前4字节
+ */
+static inline uint32_t session_home(const uint8_t* id) {
+    return ((uint32_t)id[0] | (uint32_t)id[1] << 8 | (uint32_t)id[2] << 16 | (uint32_t)id[3] << 24) & g_index_mask;
+}
+
+/**
+ * @brief 查找会话ID在哈希表中的位置
+ * @return 会话所在位置；不存在时返回探测到的空位
+ */
+static uint32_t find_index_pos(const uint8_t* id) {
+    uint32_t pos = session_home(id);
+    while (g_session_index[pos] != SESSION_INDEX_EMPTY &&
+           !constant_time_equal(g_sessions[g_session_index[pos]].id, id, AUTH_SESSION_ID_BYTES)) {
+        pos = (pos + 1) & g_index_mask;
+    }
+    return pos;
 }
 
 /**
  * @brief 根据会话ID查找会话
+ * @return 会话在g_sessions中的下标，不存在返回-1
  */
 static int find_session_by_id(const char* session_id) {
-    if (!session_id) {
+    uint8_t id[AUTH_SESSION_ID_BYTES];
+    if (!g_sessions || !parse_session_id(session_id, id)) {
         return -1;
     }
     
-    for (int i = 0; i < AUTH_MAX_SESSIONS; i++) {
-        if (g_sessions[i].is_valid && 
-            strcmp(g_sessions[i].session_id, session_id) == 0) {
-            return i;
+    // 摘要不能当作会话ID使用
+    uint16_t slot = g_session_index[find_index_pos(id)];
+    return slot == SESSION_INDEX_EMPTY || g_sessions[slot].api_key ? -1 : slot;
+}
+
+/**
+ * @brief 毫秒时间对应的时间轮刻度
+ */
+static inline uint32_t wheel_tick_of(uint64_t ms) {
+    return (uint32_t)(ms / AUTH_SESSION_WHEEL_TICK_MS);
+}
+
+/**
+ * @brief 把会话挂到expire_tick对应槽的链表头
+ */
+static void wheel_link(int slot) {
+    session_entry_t* session = &g_sessions[slot];
+    uint16_t* head = &g_wheel[session->expire_tick & (AUTH_SESSION_WHEEL_SLOTS - 1)];
+    session->wheel_prev = SESSION_INDEX_EMPTY;
+    session->wheel_next = *head;
+    if (*head != SESSION_INDEX_EMPTY) {
+        g_sessions[*head].wheel_prev = slot;
+    }
+    *head = slot;
+}
+
+/**
+ * @brief 从时间轮上摘下会话
+ */
+static void wheel_unlink(int slot) {
+    session_entry_t* session = &g_sessions[slot];
+    if (session->wheel_prev == SESSION_INDEX_EMPTY) {
+        g_wheel[session->expire_tick & (AUTH_SESSION_WHEEL_SLOTS - 1)] = session->wheel_next;
+    } else {
+        g_sessions[session->wheel_prev].wheel_next = session->wheel_next;
+    }
+    if (session->wheel_next != SESSION_INDEX_EMPTY) {
+        g_sessions[session->wheel_next].wheel_prev = session->wheel_prev;
+    }
+}
+
+/**
+ * @brief 会话按最后访问时间应挂载的到期刻度，向上取整保证不会在到期前处理
+ */
+static inline uint32_t session_expire_tick(const session_entry_t* session) {
+    return wheel_tick_of(session->last_access_time + g_session_timeout_ms) + 1;
+}
+
+/**
+ * @brief 删除会话
+ * @note 哈希表用后移删除保持探测链连续；g_sessions用最后一项填补空位，
+ *       所以按下标遍历时删除应从后往前进行
+ */
+static void remove_session(int slot) {
+    if (g_sessions[slot].api_key) {
+        g_api_key_count--;
+    } else {
+        wheel_unlink(slot);
+    }
+    
+    uint32_t hole = find_index_pos(g_sessions[slot].id);
+    uint32_t next = (hole + 1) & g_index_mask;
+    while (g_session_index[next] != SESSION_INDEX_EMPTY) {
+        // 初始位置不在(hole, next]之间的项可以前移到空位
+        uint32_t home = session_home(g_sessions[g_session_index[next]].id);
+        if (((next - home) & g_index_mask) >= ((next - hole) & g_index_mask)) {
+            g_session_index[hole] = g_session_index[next];
+            hole = next;
         }
+        next = (next + 1) & g_index_mask;
     }
-    return -1;
+    g_session_index[hole] = SESSION_INDEX_EMPTY;
+    
+    int last = g_session_count - 1;
+    if (slot != last) {
+        g_session_index[find_index_pos(g_sessions[last].id)] = slot;
+        memcpy(&g_sessions[slot], &g_sessions[last], sizeof(session_entry_t));
+        
+        // 时间轮链表中指向原最后一项的节点改为指向新位置
+        session_entry_t* moved = &g_sessions[slot];
+        if (moved->api_key) {
+            // 不在时间轮上
+        } else if (moved->wheel_prev == SESSION_INDEX_EMPTY) {
+            g_wheel[moved->expire_tick & (AUTH_SESSION_WHEEL_SLOTS - 1)] = slot;
+        } else {
+            g_sessions[moved->wheel_prev].wheel_next = slot;
+        }
+        if (moved->wheel_next != SESSION_INDEX_EMPTY) {
+            g_sessions[moved->wheel_next].wheel_prev = slot;
+        }
+    }
+    memset(&g_sessions[last], 0, sizeof(session_entry_t));
+    g_session_count--;
+}
+
+/**
+ * @brief 有会话时启动时间轮定时器，会话清空后停止
+ * @note 调用者持有g_session_mutex
+ */
+static void update_wheel_timer(uint64_t now) {
+    if (!g_wheel_timer) {
+        return;
+    }
+    int sessions = g_session_count - g_api_key_count;
+    if (sessions > 0 && !g_wheel_running) {
+        // 定时器停止期间没有会话，不需要补推进
+        g_wheel_tick = wheel_tick_of(now);
+        g_wheel_running = esp_timer_start_periodic(g_wheel_timer, AUTH_SESSION_WHEEL_TICK_MS * 1000ULL) == ESP_OK;
+    } else if (sessions == 0 && g_wheel_running) {
+        esp_timer_stop(g_wheel_timer);
+        g_wheel_running = false;
+    }
+}
+
+/**
+ * @brief 把时间轮推进到now，删除到期的会话
+ * @return 删除的会话数
+ * @note 调用者持有g_session_mutex。落后超过一圈时每个槽只检查一次
+ */
+static int advance_wheel(uint64_t now) {
+    uint32_t target = wheel_tick_of(now);
+    uint32_t steps = target - g_wheel_tick;
+    if (steps > AUTH_SESSION_WHEEL_SLOTS) {
+        steps = AUTH_SESSION_WHEEL_SLOTS;
+    }
+    
+    int expired = 0;
+    for (uint32_t i = 1; i <= steps; i++) {
+        uint16_t slot = g_wheel[(g_wheel_tick + i) & (AUTH_SESSION_WHEEL_SLOTS - 1)];
+        while (slot != SESSION_INDEX_EMPTY) {
+            session_entry_t* session = &g_sessions[slot];
+            uint16_t next = session->wheel_next;
+            if (now - session->last_access_time > g_session_timeout_ms) {
+                ESP_LOGI(TAG, "Cleaning expired session of user: %s", session->username);
+                remove_session(slot);
+                expired++;
+                // 最后一项被移到了slot，如果它正是下一个要检查的会话，改用新下标
+                if (next == g_session_count) {
+                    next = slot;
+                }
+            } else {
+                // 同一槽中后几圈才到期的会话保持不动，期间被访问过的按新的到期刻度重新挂载
+                uint32_t expire_tick = session_expire_tick(session);
+                if (expire_tick != session->expire_tick) {
+                    wheel_unlink(slot);
+                    session->expire_tick = expire_tick;
+                    wheel_link(slot);
+                }
+            }
+            slot = next;
+        }
+    }
+    g_wheel_tick = target;
+    
+    if (expired > 0) {
+        session_table_changed(now);
+    } else if (g_rtc_touch_pending) {
+        update_rtc_image(now);
+    }
+    update_wheel_timer(now);
+    return expired;
+}
+
+/**
+ * @brief 时间轮定时器回调，在esp_timer任务中执行
+ */
+static void wheel_timer_callback(void* arg) {
+    (void)arg;
+    auth_cleanup_expired_sessions();
+}
+
+/**
+ * @brief 认证和超时配置变化回调
+ * @note 会话超时变化时先删除按新超时已过期的会话，再按新超时重新挂载其余会话，缩短超时立即生效；
+ *       账号变化时更新令牌绑定的账号，验证令牌时不再读取整个认证配置
+ */
+static void on_config_changed(uint32_t sections, const system_config_t* config, void* arg) {
+    (void)arg;
+    
+    if (sections & CONFIG_SECTION_AUTH) {
+        xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+        snprintf(g_token_username, sizeof(g_token_username), "%s", config->auth.username);
+        xSemaphoreGive(g_session_mutex);
+    }
+    
+    uint32_t timeout_ms = (uint32_t)config->timeouts.session_max_age * 1000;
+    if (!(sections & CONFIG_SECTION_TIMEOUTS) || timeout_ms == 0 || timeout_ms == g_session_timeout_ms) {
+        return;
+    }
+    
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+    g_session_timeout_ms = timeout_ms;
+    
+    // 按新超时已过期的会话的到期刻度可能已被时间轮越过，挂回去要等将近一圈才会检查，这里直接删除
+    uint64_t now = auth_now_ms();
+    int expired = 0;
+    for (int i = g_session_count - 1; i >= 0; i--) {
+        if (!g_sessions[i].api_key && now - g_sessions[i].last_access_time > timeout_ms) {
+            remove_session(i);
+            expired++;
+        }
+    }
+    
+    memset(g_wheel, 0xFF, sizeof(g_wheel));
+    for (int i = 0; i < g_session_count; i++) {
+        if (!g_sessions[i].api_key) {
+            g_sessions[i].expire_tick = session_expire_tick(&g_sessions[i]);
+            wheel_link(i);
+        }
+    }
+    if (expired > 0) {
+        session_table_changed(now);
+        update_wheel_timer(now);
+    }
+    xSemaphoreGive(g_session_mutex);
+    
+    ESP_LOGI(TAG, "Session timeout set to %" PRIu32 " s, %d sessions expired", timeout_ms / 1000, expired);
+}
+
+/**
+ * @brief 生成新的当前密钥，原密钥降为上一代
+ * @note 调用者持有g_session_mutex
+ */
+static void rotate_token_key(uint64_t now) {
+    g_token_keys[1] = g_token_keys[0];
+    g_token_keys[0].generation = g_token_keys[1].generation + 1;
+    esp_fill_random(g_token_keys[0].key, sizeof(g_token_keys[0].key));
+    g_token_key_time = now;
+    session_table_changed(now);
+}
+
+/**
+ * @brief 到期时轮换密钥，由签发令牌和状态任务调用，验证令牌时不轮换
+ */
+static void update_token_keys(uint64_t now) {
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+    uint64_t elapsed = now - g_token_key_time;
+    if (elapsed >= g_session_timeout_ms) {
+        rotate_token_key(now);
+        // 超过两个周期没有轮换时上一代密钥签发的令牌也都已过期，一并替换
+        if (elapsed >= 2ULL * g_session_timeout_ms) {
+            rotate_token_key(now);
+        }
+    }
+    xSemaphoreGive(g_session_mutex);
+}
+
+/**
+ * @brief 计算令牌签名：HMAC-SHA256(密钥, 用户名 || '\0' || 签发时间 || 密钥代数)，截断为AUTH_TOKEN_MAC_BYTES
+ * @note mbedtls在ESP32上默认使用硬件SHA加速
+ */
+static esp_err_t compute_token_mac(const token_key_t* key, const char* username, uint32_t issued, uint8_t* mac) {
+    uint8_t payload[sizeof(((auth_config_t*)0)->username) + 8];
+    size_t len = strnlen(username, sizeof(((auth_config_t*)0)->username) - 1);
+    memcpy(payload, username, len);
+    payload[len++] = '\0';
+    for (int i = 3; i >= 0; i--) {
+        payload[len++] = (uint8_t)(issued >> (i * 8));
+    }
+    for (int i = 3; i >= 0; i--) {
+        payload[len++] = (uint8_t)(key->generation >> (i * 8));
+    }
+    
+    uint8_t full[32];
+    int ret = mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+                              key->key, sizeof(key->key), payload, len, full);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Failed to compute token MAC: %d", ret);
+        return ESP_FAIL;
+    }
+    memcpy(mac, full, AUTH_TOKEN_MAC_BYTES);
+    return ESP_OK;
+}
+
+/**
+ * @brief 签发令牌，格式为't' + 签发时间(秒) + 密钥代数 + MAC，均为十六进制
+ */
+static esp_err_t issue_token(const char* username, char* token) {
+    uint64_t now = auth_now_ms();
+    update_token_keys(now);
+    
+    token_key_t key;
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+    key = g_token_keys[0];
+    xSemaphoreGive(g_session_mutex);
+    
+    uint32_t issued = (uint32_t)(now / 1000);
+    uint8_t mac[AUTH_TOKEN_MAC_BYTES];
+    esp_err_t ret = compute_token_mac(&key, username, issued, mac);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    snprintf(token, AUTH_TOKEN_LENGTH + 1, "t%08" PRIx32 "%08" PRIx32, issued, key.generation);
+    bytes_to_hex_string(mac, sizeof(mac), token + 17);
+    return ESP_OK;
+}
+
+/**
+ * @brief 验证令牌
+ * @param issued_ms 输出签发时间(ms)，可为NULL
+ * @return true签名正确且未过期
+ */
+static bool validate_token(const char* token, uint64_t* issued_ms) {
+    uint8_t fields[8];
+    uint8_t mac[AUTH_TOKEN_MAC_BYTES];
+    if (!g_token_mode || !is_token(token) ||
+        !parse_hex(token + 1, fields, sizeof(fields)) || !parse_hex(token + 17, mac, sizeof(mac))) {
+        return false;
+    }
+    uint32_t issued = (uint32_t)fields[0] << 24 | (uint32_t)fields[1] << 16 | (uint32_t)fields[2] << 8 | fields[3];
+    uint32_t generation = (uint32_t)fields[4] << 24 | (uint32_t)fields[5] << 16 | (uint32_t)fields[6] << 8 | fields[7];
+    
+    uint64_t now = auth_now_ms();
+    if ((uint64_t)issued * 1000 > now || now - (uint64_t)issued * 1000 > g_session_timeout_ms) {
+        return false;
+    }
+    
+    // 令牌绑定当前配置的账号，用户名修改后原令牌失效
+    token_key_t key;
+    char username[sizeof(g_token_username)];
+    bool found = false;
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+    for (int i = 0; i < 2 && !found; i++) {
+        if (g_token_keys[i].generation == generation) {
+            key = g_token_keys[i];
+            found = true;
+        }
+    }
+    memcpy(username, g_token_username, sizeof(username));
+    xSemaphoreGive(g_session_mutex);
+    if (!found) {
+        return false;
+    }
+    
+    uint8_t expected[AUTH_TOKEN_MAC_BYTES];
+    if (compute_token_mac(&key, username, issued, expected) != ESP_OK) {
+        return false;
+    }
+    if (!constant_time_equal(mac, expected, sizeof(mac))) {
+        return false;
+    }
+    
+    if (issued_ms) {
+        *issued_ms = (uint64_t)issued * 1000;
+    }
+    return true;
+}
+
+/**
+ * @brief 从NVS读取会话镜像
+ * @return 有效的镜像，调用者释放；没有或无效时返回NULL
+ */
+static session_image_t* load_nvs_image(void) {
+    nvs_handle_t handle;
+    if (nvs_open(AUTH_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return NULL;
+    }
+    
+    session_image_t* image = malloc(sizeof(session_image_t));
+    size_t length = sizeof(session_image_t);
+    esp_err_t ret = image ? nvs_get_blob(handle, AUTH_NVS_SESSIONS_KEY, image, &length) : ESP_ERR_NO_MEM;
+    nvs_close(handle);
+    
+    if (ret != ESP_OK || !session_image_valid(image, length)) {
+        if (ret == ESP_OK) {
+            ESP_LOGW(TAG, "Persisted sessions in NVS are invalid, ignoring");
+        }
+        free(image);
+        return NULL;
+    }
+    return image;
+}
+
+/**
+ * @brief 删除NVS中的会话镜像
+ */
+static void erase_nvs_image(void) {
+    nvs_handle_t handle;
+    if (nvs_open(AUTH_NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+        if (nvs_erase_key(handle, AUTH_NVS_SESSIONS_KEY) == ESP_OK) {
+            nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+}
+
+/**
+ * @brief 删除RTC内存和NVS中的会话镜像
+ */
+static void erase_session_images(void) {
+    s_rtc_sessions.magic = 0;
+    erase_nvs_image();
+}
+
+/**
+ * @brief 启动时恢复重启前的会话和令牌密钥
+ * @param username 当前配置的账号
+ * @note 软件重启、看门狗和异常复位后优先使用RTC镜像，按RTC时间计入重启耗时；
+ *       断电后只能使用NVS镜像，断电时长无法得知，按会话超时减去AUTH_PERSIST_POWERON_GRACE_MS计算，
+ *       断电前刚访问过的会话和令牌也只剩宽限期，断电再久也不会长期有效
+ */
+static void restore_sessions(const char* username) {
+    esp_reset_reason_t reason = esp_reset_reason();
+    bool soft_reset = reason != ESP_RST_POWERON && reason != ESP_RST_BROWNOUT && reason != ESP_RST_UNKNOWN;
+    
+    session_image_t* image = NULL;
+    session_image_t* nvs_image = NULL;
+    if (soft_reset && session_image_valid(&s_rtc_sessions, session_image_size(s_rtc_sessions.count))) {
+        image = &s_rtc_sessions;
+    } else {
+        image = nvs_image = load_nvs_image();
+    }
+    if (!image) {
+        ESP_LOGI(TAG, "No persisted sessions to restore");
+        return;
+    }
+    
+    // 认证时钟从保存时继续
+    uint64_t downtime_ms = 0;
+    uint64_t rtc_now = esp_rtc_get_time_us();
+    if (nvs_image) {
+        if (g_session_timeout_ms > AUTH_PERSIST_POWERON_GRACE_MS) {
+            downtime_ms = g_session_timeout_ms - AUTH_PERSIST_POWERON_GRACE_MS;
+        }
+    } else if (rtc_now >= image->rtc_us) {
+        downtime_ms = (rtc_now - image->rtc_us) / 1000;
+    }
+    uint64_t uptime_ms = esp_timer_get_time() / 1000;
+    uint64_t clock_ms = image->clock_ms + downtime_ms;
+    g_clock_offset_ms = clock_ms > uptime_ms ? clock_ms - uptime_ms : 0;
+    uint64_t now = auth_now_ms();
+    
+    memcpy(g_token_keys, image->token_keys, sizeof(g_token_keys));
+    g_token_key_time = image->token_key_time;
+    
+    int restored = 0;
+    if (strcmp(image->username, username) == 0) {
+        for (int i = 0; i < image->count && g_session_count - g_api_key_count < g_max_sessions; i++) {
+            const persisted_session_t* record = &image->sessions[i];
+            uint32_t pos = find_index_pos(record->id);
+            if (now - record->last_access_time > g_session_timeout_ms || g_session_index[pos] != SESSION_INDEX_EMPTY) {
+                continue;
+            }
+            int slot = g_session_count++;
+            session_entry_t* session = &g_sessions[slot];
+            memcpy(session->id, record->id, sizeof(session->id));
+            snprintf(session->username, sizeof(session->username), "%s", username);
+            session->created_time = record->created_time;
+            session->last_access_time = record->last_access_time;
+            session->expire_tick = session_expire_tick(session);
+            wheel_link(slot);
+            g_session_index[pos] = slot;
+            restored++;
+        }
+    }
+    
+    ESP_LOGI(TAG, "Restored %d of %d sessions from %s, downtime %" PRIu64 " ms",
+             restored, image->count, nvs_image ? "NVS" : "RTC memory", downtime_ms);
+    free(nvs_image);
+    
+    update_wheel_timer(now);
+    update_rtc_image(now);
 }
 
 esp_err_t auth_init(void) {
@@ -74,8 +870,73 @@ esp_err_t auth_init(void) {
         return ESP_OK;
     }
     
-    // 初始化会话数组
-    memset(g_sessions, 0, sizeof(g_sessions));
+    // 按配置分配会话表并预留API密钥的位置，哈希表大小取不小于两倍表项数的2的幂
+    web_server_config_t web_config = {0};
+    g_max_sessions = 5;
+    if (config_manager_get_web_server(&web_config) == ESP_OK && web_config.max_sessions > 0) {
+        g_max_sessions = web_config.max_sessions;
+    }
+    int capacity = g_max_sessions + AUTH_MAX_API_KEYS;
+    uint32_t index_size = 1;
+    while (index_size < (uint32_t)capacity * 2) {
+        index_size <<= 1;
+    }
+    
+    g_sessions = calloc(capacity, sizeof(session_entry_t));
+    g_session_index = malloc(index_size * sizeof(uint16_t));
+    g_session_mutex = xSemaphoreCreateMutex();
+    if (!g_sessions || !g_session_index || !g_session_mutex) {
+        ESP_LOGE(TAG, "Failed to allocate session table for %d sessions", g_max_sessions);
+        auth_deinit();
+        return ESP_ERR_NO_MEM;
+    }
+    memset(g_session_index, 0xFF, index_size * sizeof(uint16_t));
+    memset(g_wheel, 0xFF, sizeof(g_wheel));
+    g_index_mask = index_size - 1;
+    g_session_count = 0;
+    g_api_key_count = 0;
+    
+    // 会话超时跟随timeouts.session_max_age，令牌绑定auth.username，订阅时立即回调一次取得初始值
+    g_session_timeout_ms = AUTH_SESSION_TIMEOUT_DEFAULT_MS;
+    if (config_manager_subscribe(CONFIG_SECTION_TIMEOUTS | CONFIG_SECTION_AUTH, on_config_changed, NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to subscribe session timeout, using default %d s",
+                 AUTH_SESSION_TIMEOUT_DEFAULT_MS / 1000);
+    }
+    
+    // 令牌模式的两代密钥都随机生成
+    g_token_mode = web_config.stateless_sessions != 0;
+    esp_fill_random(g_token_keys, sizeof(g_token_keys));
+    g_token_keys[0].generation = 1;
+    g_token_keys[1].generation = 0;
+    g_token_key_time = auth_now_ms();
+    
+    // 会话表模式由时间轮定时器清理过期会话，第一个会话创建时启动
+    if (!g_token_mode) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = wheel_timer_callback,
+            .name = "auth_wheel",
+        };
+        esp_err_t ret = esp_timer_create(&timer_args, &g_wheel_timer);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create session expiry timer: %s", esp_err_to_name(ret));
+            auth_deinit();
+            return ret;
+        }
+    }
+    
+    load_api_keys();
+    
+    // 恢复重启前的会话和令牌密钥；关闭持久化时删除旧镜像，之前的会话不会在以后重新出现
+    g_persist_enabled = web_config.persist_sessions != 0;
+    if (g_persist_enabled) {
+        auth_config_t auth_config;
+        if (config_manager_get_auth(&auth_config) == ESP_OK) {
+            restore_sessions(auth_config.username);
+        }
+    } else {
+        erase_session_images();
+    }
+    g_nvs_save_time = auth_now_ms();
     
     // 测试SHA-256计算
     char test_hash[65];
@@ -90,17 +951,47 @@ esp_err_t auth_init(void) {
     }
     
     g_auth_initialized = true;
-    ESP_LOGI(TAG, "Authentication module initialized");
+    ESP_LOGI(TAG, "Authentication module initialized, %s, max sessions: %d, session timeout: %" PRIu32 " s",
+             g_token_mode ? "stateless tokens" : "session table", g_max_sessions, g_session_timeout_ms / 1000);
     return ESP_OK;
 }
 
-esp_err_t auth_calculate_sha256(const char* input, char* output) {
-    if (!input || !output) {
-        return ESP_ERR_INVALID_ARG;
+void auth_deinit(void) {
+    config_manager_unsubscribe(on_config_changed, NULL);
+    if (g_wheel_timer) {
+        esp_timer_stop(g_wheel_timer);
+        esp_timer_delete(g_wheel_timer);
+        g_wheel_timer = NULL;
     }
-    
+    g_wheel_running = false;
+    if (g_session_mutex) {
+        vSemaphoreDelete(g_session_mutex);
+        g_session_mutex = NULL;
+    }
+    free(g_sessions);
+    free(g_session_index);
+    g_sessions = NULL;
+    g_session_index = NULL;
+    g_index_mask = 0;
+    g_session_count = 0;
+    g_api_key_count = 0;
+    g_token_mode = false;
+    memset(g_token_keys, 0, sizeof(g_token_keys));
+    memset(g_token_username, 0, sizeof(g_token_username));
+    memset(g_throttle, 0, sizeof(g_throttle));
+    g_persist_enabled = false;
+    g_rtc_touch_pending = false;
+    g_nvs_members_dirty = false;
+    g_nvs_touch_dirty = false;
+    g_clock_offset_ms = 0;
+    g_auth_initialized = false;
+}
+
+/**
+ * @brief 计算SHA-256哈希值
+ */
+static esp_err_t sha256_bytes(const char* input, uint8_t* hash) {
     mbedtls_sha256_context ctx;
-    uint8_t hash[32];
     
     mbedtls_sha256_init(&ctx);
     
@@ -126,57 +1017,144 @@ esp_err_t auth_calculate_sha256(const char* input, char* output) {
     }
     
     mbedtls_sha256_free(&ctx);
+    return ESP_OK;
+}
+
+esp_err_t auth_calculate_sha256(const char* input, char* output) {
+    if (!input || !output) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    uint8_t hash[32];
+    esp_err_t ret = sha256_bytes(input, hash);
+    if (ret != ESP_OK) {
+        return ret;
+    }
     
     // 转换为十六进制字符串
     bytes_to_hex_string(hash, 32, output);
     
-    return ESP_OK;
+    return ESP_OK;
+}
+
+/**
+ * @brief 用随机盐计算密码的PBKDF2-HMAC-SHA256哈希
+ * @param output 输出AUTH_PBKDF2_PREFIX格式的字符串
+ * @note mbedtls在ESP32上默认使用硬件SHA加速，每次迭代为两次HMAC-SHA256
+ */
+static esp_err_t hash_password(const char* password, int iterations, char* output, size_t output_size) {
+    uint8_t salt[AUTH_PBKDF2_SALT_BYTES];
+    uint8_t hash[AUTH_PBKDF2_HASH_BYTES];
+    esp_fill_random(salt, sizeof(salt));
+    
+    int ret = mbedtls_pkcs5_pbkdf2_hmac_ext(MBEDTLS_MD_SHA256, (const unsigned char*)password, strlen(password),
+                                            salt, sizeof(salt), iterations, sizeof(hash), hash);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Failed to compute PBKDF2: %d", ret);
+        return ESP_FAIL;
+    }
+    
+    char salt_hex[AUTH_PBKDF2_SALT_BYTES * 2 + 1];
+    char hash_hex[AUTH_PBKDF2_HASH_BYTES * 2 + 1];
+    bytes_to_hex_string(salt, sizeof(salt), salt_hex);
+    bytes_to_hex_string(hash, sizeof(hash), hash_hex);
+    int len = snprintf(output, output_size, AUTH_PBKDF2_PREFIX "%d$%s$%s", iterations, salt_hex, hash_hex);
+    return len > 0 && (size_t)len < output_size ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+/**
+ * @brief 按保存的哈希格式验证密码，结果以二进制常量时间比较
+ * @param stored 保存的哈希：AUTH_PBKDF2_PREFIX格式或旧版64字符SHA-256
+ * @param iterations 当前配置的迭代次数
+ * @param needs_rehash 输出是否需要按当前配置重新计算
+ */
+static bool check_password(const char* stored, const char* password, int iterations, bool* needs_rehash) {
+    uint8_t expected[AUTH_PBKDF2_HASH_BYTES];
+    uint8_t actual[AUTH_PBKDF2_HASH_BYTES];
+    size_t prefix_len = strlen(AUTH_PBKDF2_PREFIX);
+    
+    if (strncmp(stored, AUTH_PBKDF2_PREFIX, prefix_len) == 0) {
+        // pbkdf2-sha256$迭代次数$盐$哈希
+        uint8_t salt[AUTH_PBKDF2_SALT_BYTES];
+        char* end;
+        long stored_iterations = strtol(stored + prefix_len, &end, 10);
+        if (stored_iterations <= 0 || *end != '$' ||
+            strlen(end + 1) != sizeof(salt) * 2 + 1 + sizeof(expected) * 2 || end[1 + sizeof(salt) * 2] != '$' ||
+            !parse_hex(end + 1, salt, sizeof(salt)) || !parse_hex(end + 2 + sizeof(salt) * 2, expected, sizeof(expected))) {
+            ESP_LOGE(TAG, "Malformed password hash");
+            return false;
+        }
+        
+        int ret = mbedtls_pkcs5_pbkdf2_hmac_ext(MBEDTLS_MD_SHA256, (const unsigned char*)password, strlen(password),
+                                                salt, sizeof(salt), stored_iterations, sizeof(actual), actual);
+        if (ret != 0) {
+            ESP_LOGE(TAG, "Failed to compute PBKDF2: %d", ret);
+            return false;
+        }
+        *needs_rehash = stored_iterations != iterations;
+    } else {
+        // 旧版无盐SHA-256
+        if (strlen(stored) != sizeof(expected) * 2 || !parse_hex(stored, expected, sizeof(expected)) ||
+            sha256_bytes(password, actual) != ESP_OK) {
+            return false;
+        }
+        *needs_rehash = true;
+    }
+    
+    return constant_time_equal(expected, actual, sizeof(expected));
 }
 
-bool auth_verify_password(const char* username, const char* password) {
-    if (!username || !password) {
-        ESP_LOGE(TAG, "Invalid username or password");
-        return false;
-    }
-    
-    ESP_LOGI(TAG, "Verifying login - Username: '%s', Password: '%s'", username, password);
-    
-    // 获取认证配置
-    auth_config_t auth_config;
-    esp_err_t ret = config_manager_get_auth(&auth_config);
-    if (ret != ESP_OK) {
+/**
+ * @brief 验证用户名和密码
+ * @param rehash 哈希格式过时时是否重新计算并保存
+ */
+static bool verify_password(const char* username, const char* password, bool rehash) {
+    // 只复制需要的字段，计算期间不持有配置快照
+    const system_config_t* config = config_manager_acquire(NULL);
+    if (!config) {
         ESP_LOGE(TAG, "Failed to get auth config");
         return false;
     }
+    bool username_ok = strcmp(username, config->auth.username) == 0;
+    char stored[sizeof(config->auth.password_hash)];
+    memcpy(stored, config->auth.password_hash, sizeof(stored));
+    int iterations = config->auth.pbkdf2_iterations;
+    config_manager_release(config);
     
-    ESP_LOGI(TAG, "Config loaded - Username: '%s', Password hash: '%s'", auth_config.username, auth_config.password_hash);
-    
-    // 检查用户名
-    if (strcmp(username, auth_config.username) != 0) {
-        ESP_LOGW(TAG, "Invalid username: '%s' (expected: '%s')", username, auth_config.username);
+    if (!username_ok) {
+        ESP_LOGW(TAG, "Invalid username: '%s'", username);
         return false;
     }
     
-    // 计算输入密码的哈希值
-    char password_hash[65];
-    ret = auth_calculate_sha256(password, password_hash);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to calculate password hash");
+    bool needs_rehash = false;
+    if (!check_password(stored, password, iterations, &needs_rehash)) {
+        ESP_LOGW(TAG, "Password verification failed for user: %s", username);
         return false;
     }
     
-    ESP_LOGI(TAG, "Calculated hash: '%s'", password_hash);
-    ESP_LOGI(TAG, "Expected hash:   '%s'", auth_config.password_hash);
+    if (rehash && needs_rehash) {
+        auth_config_t auth_config;
+        if (config_manager_get_auth(&auth_config) == ESP_OK &&
+            hash_password(password, iterations, auth_config.password_hash, sizeof(auth_config.password_hash)) == ESP_OK &&
+            config_manager_set_auth(&auth_config) == ESP_OK) {
+            ESP_LOGI(TAG, "Password hash of user %s upgraded to PBKDF2 with %d iterations", username, iterations);
+        } else {
+            ESP_LOGW(TAG, "Failed to upgrade password hash of user %s", username);
+        }
+    }
     
-    // 比较哈希值
-    if (strcmp(password_hash, auth_config.password_hash) == 0) {
-        ESP_LOGI(TAG, "Password verification successful for user: %s", username);
-        return true;
-    } else {
-        ESP_LOGW(TAG, "Password verification failed for user: %s", username);
-        ESP_LOGW(TAG, "Hash mismatch - calculated vs expected");
+    ESP_LOGI(TAG, "Password verification successful for user: %s", username);
+    return true;
+}
+
+
+bool auth_verify_password(const char* username, const char* password) {
+    if (!username || !password) {
+        ESP_LOGE(TAG, "Invalid username or password");
         return false;
     }
+    
+    return verify_password(username, password, true);
 }
 
 esp_err_t auth_change_password(const char* username, const char* old_password, const char* new_password) {
@@ -184,35 +1162,41 @@ esp_err_t auth_change_password(const char* username, const char* old_password, c
         return ESP_ERR_INVALID_ARG;
     }
     
-    // 验证旧密码
-    if (!auth_verify_password(username, old_password)) {
+    // 验证旧密码，旧哈希马上会被替换，不需要迁移
+    if (!verify_password(username, old_password, false)) {
         ESP_LOGW(TAG, "Old password verification failed");
         return ESP_ERR_INVALID_ARG;
     }
     
-    // 计算新密码的哈希值
-    char new_password_hash[65];
-    esp_err_t ret = auth_calculate_sha256(new_password, new_password_hash);
+    // 用新的随机盐计算新密码的哈希值
+    auth_config_t auth_config;
+    esp_err_t ret = config_manager_get_auth(&auth_config);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to calculate new password hash");
+        ESP_LOGE(TAG, "Failed to get auth config");
         return ret;
     }
     
-    // 更新配置
-    auth_config_t auth_config;
-    ret = config_manager_get_auth(&auth_config);
+    ret = hash_password(new_password, auth_config.pbkdf2_iterations,
+                        auth_config.password_hash, sizeof(auth_config.password_hash));
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to get auth config");
+        ESP_LOGE(TAG, "Failed to calculate new password hash");
         return ret;
     }
     
-    strcpy(auth_config.password_hash, new_password_hash);
     ret = config_manager_set_auth(&auth_config);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to save new password");
         return ret;
     }
     
+    // 令牌无法逐个吊销，修改密码时替换两代密钥使已签发的令牌全部失效
+    uint64_t now = auth_now_ms();
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+    rotate_token_key(now);
+    rotate_token_key(now);
+    xSemaphoreGive(g_session_mutex);
+    save_session_image(true);
+    
     ESP_LOGI(TAG, "Password changed successfully for user: %s", username);
     return ESP_OK;
 }
@@ -222,8 +1206,8 @@ esp_err_t auth_generate_session_id(char* session_id) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    // 生成32字节随机数据
-    uint8_t random_bytes[16];
+    // 生成16字节随机数据
+    uint8_t random_bytes[AUTH_SESSION_ID_BYTES];
     esp_fill_random(random_bytes, sizeof(random_bytes));
     
     // 转换为十六进制字符串
@@ -247,32 +1231,54 @@ esp_err_t auth_login(const char* username, const char* password, char* session_i
         return ESP_ERR_INVALID_ARG;
     }
     
-    // 清理过期会话
-    auth_cleanup_expired_sessions();
+    // 令牌模式不占用会话表
+    if (g_token_mode) {
+        esp_err_t ret = issue_token(username, session_id);
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "User %s logged in successfully, token key generation: %.8s",
+                     username, session_id + 9);
+        }
+        return ret;
+    }
     
-    // 查找空闲会话槽位
-    int slot = find_free_session_slot();
-    if (slot < 0) {
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+    uint64_t now = auth_now_ms();
+    
+    // 表满时先把时间轮推进到当前时刻，只处理到期的槽
+    if (g_session_count - g_api_key_count >= g_max_sessions) {
+        advance_wheel(now);
+    }
+    if (g_session_count - g_api_key_count >= g_max_sessions) {
+        xSemaphoreGive(g_session_mutex);
         ESP_LOGW(TAG, "No available session slots");
         return ESP_ERR_NO_MEM;
     }
     
-    // 生成会话ID
-    esp_err_t ret = auth_generate_session_id(session_id);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to generate session ID");
-        return ret;
-    }
+    // 生成会话ID，与已有会话重复时重新生成
+    uint8_t id[AUTH_SESSION_ID_BYTES];
+    uint32_t pos;
+    do {
+        auth_generate_session_id(session_id);
+        parse_session_id(session_id, id);
+        pos = find_index_pos(id);
+    } while (g_session_index[pos] != SESSION_INDEX_EMPTY);
     
-    // 创建新会话
-    uint64_t now = esp_timer_get_time() / 1000;  // 转换为毫秒
-    strcpy(g_sessions[slot].session_id, session_id);
-    strcpy(g_sessions[slot].username, username);
-    g_sessions[slot].created_time = now;
-    g_sessions[slot].last_access_time = now;
-    g_sessions[slot].is_valid = true;
+    // 创建新会话并挂到时间轮上
+    int slot = g_session_count++;
+    session_entry_t* session = &g_sessions[slot];
+    memcpy(session->id, id, sizeof(session->id));
+    snprintf(session->username, sizeof(session->username), "%s", username);
+    session->created_time = now;
+    session->last_access_time = now;
+    session->expire_tick = session_expire_tick(session);
+    wheel_link(slot);
+    g_session_index[pos] = slot;
+    session_table_changed(now);
+    update_wheel_timer(now);
+    xSemaphoreGive(g_session_mutex);
     
-    ESP_LOGI(TAG, "User %s logged in successfully, session: %s", username, session_id);
+    // 日志只记录会话ID前缀，能读取串口日志的人不能据此登录
+    ESP_LOGI(TAG, "User %s logged in successfully, session: %.8s...", username, session_id);
     return ESP_OK;
 }
 
@@ -285,16 +1291,30 @@ esp_err_t auth_logout(const char* session_id) {
         return ESP_ERR_INVALID_STATE;
     }
     
+    // 令牌无服务端状态，由调用者清除cookie
+    if (is_token(session_id)) {
+        return validate_token(session_id, NULL) ? ESP_OK : ESP_ERR_NOT_FOUND;
+    }
+    
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
     int slot = find_session_by_id(session_id);
     if (slot < 0) {
+        xSemaphoreGive(g_session_mutex);
         ESP_LOGW(TAG, "Session not found: %s", session_id);
         return ESP_ERR_NOT_FOUND;
     }
     
     // 清除会话
-    memset(&g_sessions[slot], 0, sizeof(auth_session_t));
+    uint64_t now = auth_now_ms();
+    remove_session(slot);
+    session_table_changed(now);
+    update_wheel_timer(now);
+    xSemaphoreGive(g_session_mutex);
     
-    ESP_LOGI(TAG, "Session logged out: %s", session_id);
+    // 立即写入NVS，断电后登出的会话不会恢复
+    save_session_image(true);
+    
+    ESP_LOGI(TAG, "Session logged out: %.8s...", session_id);
     return ESP_OK;
 }
 
@@ -303,24 +1323,33 @@ bool auth_validate_session(const char* session_id) {
         return false;
     }
     
-    int slot = find_session_by_id(session_id);
-    if (slot < 0) {
-        return false;
+    if (is_token(session_id)) {
+        return validate_token(session_id, NULL);
     }
-    
-    uint64_t now = esp_timer_get_time() / 1000;  // 转换为毫秒
-    
-    // 检查会话是否过期
-    if (now - g_sessions[slot].last_access_time > AUTH_SESSION_TIMEOUT_MS) {
-        ESP_LOGW(TAG, "Session expired: %s", session_id);
-        memset(&g_sessions[slot], 0, sizeof(auth_session_t));
-        return false;
+    if (auth_is_api_key(session_id)) {
+        return validate_api_key(session_id);
     }
     
-    // 更新最后访问时间
-    g_sessions[slot].last_access_time = now;
+    // 过期会话通常由时间轮删除，这里只更新最后访问时间，不移动时间轮节点；
+    // 时间轮定时器晚到时也按空闲时间拒绝，过期不依赖定时器调度
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+    int slot = find_session_by_id(session_id);
+    if (slot >= 0) {
+        uint64_t now = auth_now_ms();
+        if (now - g_sessions[slot].last_access_time > g_session_timeout_ms) {
+            remove_session(slot);
+            session_table_changed(now);
+            update_wheel_timer(now);
+            slot = -1;
+        } else {
+            g_sessions[slot].last_access_time = now;
+            g_rtc_touch_pending = true;
+            g_nvs_touch_dirty = true;
+        }
+    }
+    xSemaphoreGive(g_session_mutex);
     
-    return true;
+    return slot >= 0;
 }
 
 esp_err_t auth_get_session_info(const char* session_id, auth_session_t* session) {
@@ -332,31 +1361,123 @@ esp_err_t auth_get_session_info(const char* session_id, auth_session_t* session)
         return ESP_ERR_INVALID_STATE;
     }
     
+    if (is_token(session_id)) {
+        uint64_t issued_ms;
+        if (!validate_token(session_id, &issued_ms)) {
+            return ESP_ERR_NOT_FOUND;
+        }
+        memset(session, 0, sizeof(auth_session_t));
+        snprintf(session->session_id, sizeof(session->session_id), "%s", session_id);
+        xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+        snprintf(session->username, sizeof(session->username), "%s", g_token_username);
+        xSemaphoreGive(g_session_mutex);
+        session->created_time = issued_ms;
+        session->last_access_time = auth_now_ms();
+        session->is_valid = true;
+        return ESP_OK;
+    }
+    
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
     int slot = find_session_by_id(session_id);
     if (slot < 0) {
+        xSemaphoreGive(g_session_mutex);
         return ESP_ERR_NOT_FOUND;
     }
     
-    memcpy(session, &g_sessions[slot], sizeof(auth_session_t));
+    memset(session, 0, sizeof(auth_session_t));
+    bytes_to_hex_string(g_sessions[slot].id, AUTH_SESSION_ID_BYTES, session->session_id);
+    snprintf(session->username, sizeof(session->username), "%s", g_sessions[slot].username);
+    session->created_time = g_sessions[slot].created_time;
+    session->last_access_time = g_sessions[slot].last_access_time;
+    session->is_valid = true;
+    xSemaphoreGive(g_session_mutex);
     return ESP_OK;
 }
 
-int auth_cleanup_expired_sessions(void) {
+esp_err_t auth_save_sessions(void) {
     if (!g_auth_initialized) {
-        return 0;
+        return ESP_OK;
+    }
+    
+    // 令牌密钥在这里按周期轮换，验证令牌时只做一次MAC计算
+    if (g_token_mode) {
+        update_token_keys(auth_now_ms());
+    }
+    return save_session_image(false);
+}
+
+/**
+ * @brief 把会话镜像写入NVS
+ * @param force true不检查写入预算立即写入，用于登出和修改密码；写入失败时删除NVS镜像，
+ *              断电后宁可不恢复会话也不恢复已吊销的会话
+ */
+static esp_err_t save_session_image(bool force) {
+    if (!g_persist_enabled) {
+        return ESP_OK;
+    }
+    
+    // 会话增删和只有访问时间变化分别按各自的最短间隔写入
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+    uint64_t now = auth_now_ms();
+    uint64_t elapsed = now - g_nvs_save_time;
+    bool due = force ||
+               (g_nvs_members_dirty && elapsed >= AUTH_PERSIST_NVS_INTERVAL_MS) ||
+               (g_nvs_touch_dirty && elapsed >= AUTH_PERSIST_TOUCH_INTERVAL_MS);
+    if (!due) {
+        xSemaphoreGive(g_session_mutex);
+        return ESP_OK;
+    }
+    
+    session_image_t* image = malloc(sizeof(session_image_t));
+    if (!image) {
+        xSemaphoreGive(g_session_mutex);
+        return ESP_ERR_NO_MEM;
     }
+    build_session_image(image, now);
+    g_nvs_members_dirty = false;
+    g_nvs_touch_dirty = false;
+    g_nvs_save_time = now;
+    xSemaphoreGive(g_session_mutex);
     
-    int cleaned_count = 0;
-    uint64_t now = esp_timer_get_time() / 1000;  // 转换为毫秒
+    // 写flash不持有会话锁
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(AUTH_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(handle, AUTH_NVS_SESSIONS_KEY, image, session_image_size(image->count));
+        if (ret == ESP_OK) {
+            ret = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
     
-    for (int i = 0; i < AUTH_MAX_SESSIONS; i++) {
-        if (g_sessions[i].is_valid && 
-            now - g_sessions[i].last_access_time > AUTH_SESSION_TIMEOUT_MS) {
-            ESP_LOGI(TAG, "Cleaning expired session: %s", g_sessions[i].session_id);
-            memset(&g_sessions[i], 0, sizeof(auth_session_t));
-            cleaned_count++;
+    if (ret == ESP_OK) {
+        ESP_LOGD(TAG, "Saved %d sessions to NVS", image->count);
+    } else {
+        // 下一个间隔重试
+        ESP_LOGW(TAG, "Failed to save sessions to NVS: %s", esp_err_to_name(ret));
+        if (force) {
+            erase_nvs_image();
         }
+        xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+        g_nvs_members_dirty = true;
+        xSemaphoreGive(g_session_mutex);
     }
+    free(image);
+    return ret;
+}
+
+uint32_t auth_get_session_timeout_ms(void) {
+    return g_session_timeout_ms;
+}
+
+int auth_cleanup_expired_sessions(void) {
+    if (!g_auth_initialized || !g_sessions) {
+        return 0;
+    }
+    
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+    int cleaned_count = advance_wheel(auth_now_ms());
+    xSemaphoreGive(g_session_mutex);
     
     if (cleaned_count > 0) {
         ESP_LOGI(TAG, "Cleaned %d expired sessions", cleaned_count);
@@ -364,3 +1485,404 @@ int auth_cleanup_expired_sessions(void) {
     
     return cleaned_count;
 }
+
+/**
+ * @brief 查找客户端的限速记录，不存在时创建
+ * @note 表满时替换最久未出现的记录，优先替换不在锁定期的
+ */
+static throttle_entry_t* find_throttle_entry(const uint8_t* client, uint64_t now) {
+    throttle_entry_t* victim = &g_throttle[0];
+    for (int i = 0; i < AUTH_THROTTLE_CLIENTS; i++) {
+        throttle_entry_t* entry = &g_throttle[i];
+        if (entry->in_use && memcmp(entry->addr, client, AUTH_CLIENT_ADDR_BYTES) == 0) {
+            return entry;
+        }
+        if (victim->in_use) {
+            bool entry_locked = entry->locked_until > now;
+            bool victim_locked = victim->locked_until > now;
+            if (!entry->in_use || entry_locked < victim_locked ||
+                (entry_locked == victim_locked && entry->last_seen < victim->last_seen)) {
+                victim = entry;
+            }
+        }
+    }
+    
+    memset(victim, 0, sizeof(throttle_entry_t));
+    memcpy(victim->addr, client, AUTH_CLIENT_ADDR_BYTES);
+    victim->in_use = true;
+    victim->tokens_milli = AUTH_LOGIN_BURST * 1000;
+    victim->refill_time = now;
+    return victim;
+}
+
+bool auth_login_throttle_allow(const uint8_t* client, uint32_t* retry_after_ms) {
+    if (!client) {
+        return false;
+    }
+    
+    uint64_t now = auth_now_ms();
+    throttle_entry_t* entry = find_throttle_entry(client, now);
+    entry->last_seen = now;
+    
+    if (now < entry->locked_until) {
+        if (retry_after_ms) {
+            *retry_after_ms = entry->locked_until - now;
+        }
+        return false;
+    }
+    
+    // 按经过的时间补充尝试机会，不超过桶容量
+    uint64_t tokens = entry->tokens_milli + (now - entry->refill_time) * 1000 / AUTH_LOGIN_REFILL_MS;
+    if (tokens > AUTH_LOGIN_BURST * 1000) {
+        tokens = AUTH_LOGIN_BURST * 1000;
+    }
+    entry->refill_time = now;
+    
+    if (tokens < 1000) {
+        entry->tokens_milli = tokens;
+        if (retry_after_ms) {
+            *retry_after_ms = (1000 - tokens) * AUTH_LOGIN_REFILL_MS / 1000;
+        }
+        return false;
+    }
+    
+    entry->tokens_milli = tokens - 1000;
+    return true;
+}
+
+void auth_login_throttle_record(const uint8_t* client, bool success) {
+    if (!client) {
+        return;
+    }
+    
+    uint64_t now = auth_now_ms();
+    throttle_entry_t* entry = find_throttle_entry(client, now);
+    entry->last_seen = now;
+    
+    if (success) {
+        entry->failures = 0;
+        entry->locked_until = 0;
+        return;
+    }
+    
+    if (entry->failures < UINT8_MAX) {
+        entry->failures++;
+    }
+    if (entry->failures >= AUTH_LOGIN_LOCKOUT_THRESHOLD) {
+        // 锁定时长随连续失败次数指数增长
+        uint32_t shift = entry->failures - AUTH_LOGIN_LOCKOUT_THRESHOLD;
+        uint64_t lockout = shift < 32 ? (uint64_t)AUTH_LOGIN_LOCKOUT_BASE_MS << shift : AUTH_LOGIN_LOCKOUT_MAX_MS;
+        if (lockout > AUTH_LOGIN_LOCKOUT_MAX_MS) {
+            lockout = AUTH_LOGIN_LOCKOUT_MAX_MS;
+        }
+        entry->locked_until = now + lockout;
+        ESP_LOGW(TAG, "Login locked for %" PRIu32 " s after %d consecutive failures",
+                 (uint32_t)(lockout / 1000), entry->failures);
+    }
+}
+
+esp_err_t auth_parse_cookie(const char* cookie_header, char* session_id) {
+    static const char name[] = "session_id";
+    const size_t name_len = sizeof(name) - 1;
+    if (!cookie_header || !session_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // 逐个名值对比较名称，名称必须完全相同，"xsession_id"之类不算
+    const char* p = cookie_header;
+    while (*p) {
+        while (*p == ';' || *p == ' ' || *p == '\t') {
+            p++;
+        }
+        const char* pair = p;
+        while (*p && *p != ';') {
+            p++;
+        }
+        if ((size_t)(p - pair) <= name_len || memcmp(pair, name, name_len) != 0 || pair[name_len] != '=') {
+            continue;
+        }
+        
+        const char* value = pair + name_len + 1;
+        const char* end = p;
+        while (end > value && (end[-1] == ' ' || end[-1] == '\t')) {
+            end--;
+        }
+        size_t len = end - value;
+        if (len > AUTH_CREDENTIAL_MAX_LENGTH) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(session_id, value, len);
+        session_id[len] = '\0';
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t auth_parse_bearer(const char* authorization, char* credential) {
+    static const char scheme[] = "Bearer";
+    const size_t scheme_len = sizeof(scheme) - 1;
+    if (!authorization || !credential) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // 认证方案名不区分大小写
+    if (strncasecmp(authorization, scheme, scheme_len) != 0 || authorization[scheme_len] != ' ') {
+        return ESP_ERR_NOT_FOUND;
+    }
+    const char* value = authorization + scheme_len;
+    while (*value == ' ') {
+        value++;
+    }
+    size_t len = strcspn(value, " \t");
+    if (len == 0 || value[len + strspn(value + len, " \t")] != '\0') {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (len > AUTH_CREDENTIAL_MAX_LENGTH) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(credential, value, len);
+    credential[len] = '\0';
+    return ESP_OK;
+}
+
+bool auth_is_api_key(const char* credential) {
+    return credential && credential[0] == 'k' && strlen(credential) == AUTH_API_KEY_LENGTH;
+}
+
+/**
+ * @brief 计算API密钥在会话表中的键：密钥字符串SHA-256的前AUTH_SESSION_ID_BYTES字节
+ * @note 会话表和NVS只保存摘要，读出flash也得不到可用的密钥
+ */
+static bool api_key_digest(const char* api_key, uint8_t* digest) {
+    uint8_t raw[AUTH_API_KEY_BYTES];
+    uint8_t hash[32];
+    if (!auth_is_api_key(api_key) || !parse_hex(api_key + 1, raw, sizeof(raw)) || sha256_bytes(api_key, hash) != ESP_OK) {
+        return false;
+    }
+    memcpy(digest, hash, AUTH_SESSION_ID_BYTES);
+    return true;
+}
+
+/**
+ * @brief 按名称查找API密钥
+ * @return 在g_sessions中的下标，不存在返回-1
+ * @note 调用者持有g_session_mutex。只在创建和吊销时使用，直接遍历
+ */
+static int find_api_key_by_name(const char* name) {
+    for (int i = 0; i < g_session_count; i++) {
+        if (g_sessions[i].api_key && strcmp(g_sessions[i].username, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 把API密钥摘要加入会话表
+ * @return 在g_sessions中的下标，摘要已存在或API密钥已满时返回-1
+ * @note 调用者持有g_session_mutex
+ */
+static int insert_api_key(const uint8_t* digest, const char* name) {
+    uint32_t pos = find_index_pos(digest);
+    if (g_session_index[pos] != SESSION_INDEX_EMPTY || g_api_key_count >= AUTH_MAX_API_KEYS) {
+        return -1;
+    }
+    
+    int slot = g_session_count++;
+    session_entry_t* entry = &g_sessions[slot];
+    memset(entry, 0, sizeof(session_entry_t));
+    memcpy(entry->id, digest, sizeof(entry->id));
+    snprintf(entry->username, sizeof(entry->username), "%s", name);
+    entry->wheel_prev = SESSION_INDEX_EMPTY;
+    entry->wheel_next = SESSION_INDEX_EMPTY;
+    entry->api_key = true;
+    g_session_index[pos] = slot;
+    g_api_key_count++;
+    return slot;
+}
+
+/**
+ * @brief 验证API密钥，摘要在持锁前计算
+ */
+static bool validate_api_key(const char* api_key) {
+    uint8_t digest[AUTH_SESSION_ID_BYTES];
+    if (!api_key_digest(api_key, digest)) {
+        return false;
+    }
+    
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+    uint16_t slot = g_session_index[find_index_pos(digest)];
+    bool valid = slot != SESSION_INDEX_EMPTY && g_sessions[slot].api_key;
+    if (valid) {
+        g_sessions[slot].last_access_time = auth_now_ms();
+    }
+    xSemaphoreGive(g_session_mutex);
+    return valid;
+}
+
+/**
+ * @brief 计算API密钥镜像的CRC32，crc字段按0计算
+ */
+static uint32_t api_key_image_crc(api_key_image_t* image) {
+    uint32_t saved = image->crc;
+    image->crc = 0;
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)image, sizeof(api_key_image_t));
+    image->crc = saved;
+    return crc;
+}
+
+/**
+ * @brief 启动时从NVS加载API密钥
+ */
+static void load_api_keys(void) {
+    nvs_handle_t handle;
+    if (nvs_open(AUTH_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+    api_key_image_t image;
+    size_t length = sizeof(image);
+    esp_err_t ret = nvs_get_blob(handle, AUTH_NVS_API_KEYS_KEY, &image, &length);
+    nvs_close(handle);
+    if (ret != ESP_OK) {
+        return;
+    }
+    if (length != sizeof(image) || image.magic != API_KEY_IMAGE_MAGIC || image.version != API_KEY_IMAGE_VERSION ||
+        image.count > AUTH_MAX_API_KEYS || image.crc != api_key_image_crc(&image)) {
+        ESP_LOGW(TAG, "API keys in NVS are invalid, ignoring");
+        return;
+    }
+    
+    for (int i = 0; i < image.count; i++) {
+        image.keys[i].name[AUTH_API_KEY_NAME_MAX] = '\0';
+        insert_api_key(image.keys[i].digest, image.keys[i].name);
+    }
+    ESP_LOGI(TAG, "Loaded %d API keys", g_api_key_count);
+}
+
+/**
+ * @brief 把全部API密钥摘要写入NVS
+ */
+static esp_err_t save_api_keys(void) {
+    api_key_image_t image;
+    memset(&image, 0, sizeof(image));
+    image.magic = API_KEY_IMAGE_MAGIC;
+    image.version = API_KEY_IMAGE_VERSION;
+    
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+    for (int i = 0; i < g_session_count && image.count < AUTH_MAX_API_KEYS; i++) {
+        if (g_sessions[i].api_key) {
+            persisted_api_key_t* record = &image.keys[image.count++];
+            memcpy(record->digest, g_sessions[i].id, sizeof(record->digest));
+            snprintf(record->name, sizeof(record->name), "%s", g_sessions[i].username);
+        }
+    }
+    xSemaphoreGive(g_session_mutex);
+    image.crc = api_key_image_crc(&image);
+    
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(AUTH_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(handle, AUTH_NVS_API_KEYS_KEY, &image, sizeof(image));
+        if (ret == ESP_OK) {
+            ret = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save API keys to NVS: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t auth_create_api_key(const char* name, char* api_key) {
+    if (!name || !api_key || name[0] == '\0' || strlen(name) > AUTH_API_KEY_NAME_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (!g_auth_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+    if (find_api_key_by_name(name) >= 0) {
+        xSemaphoreGive(g_session_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (g_api_key_count >= AUTH_MAX_API_KEYS) {
+        xSemaphoreGive(g_session_mutex);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // 生成随机密钥，摘要与已有表项重复时重新生成
+    uint8_t random_bytes[AUTH_API_KEY_BYTES];
+    uint8_t digest[AUTH_SESSION_ID_BYTES];
+    int slot;
+    do {
+        esp_fill_random(random_bytes, sizeof(random_bytes));
+        api_key[0] = 'k';
+        bytes_to_hex_string(random_bytes, sizeof(random_bytes), api_key + 1);
+        api_key_digest(api_key, digest);
+        slot = insert_api_key(digest, name);
+    } while (slot < 0);
+    xSemaphoreGive(g_session_mutex);
+    
+    // 写入失败时撤销，避免重启后密钥消失
+    esp_err_t ret = save_api_keys();
+    if (ret != ESP_OK) {
+        xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+        slot = find_api_key_by_name(name);
+        if (slot >= 0) {
+            remove_session(slot);
+        }
+        xSemaphoreGive(g_session_mutex);
+        memset(api_key, 0, AUTH_API_KEY_LENGTH + 1);
+        return ret;
+    }
+    
+    ESP_LOGI(TAG, "API key created: %s", name);
+    return ESP_OK;
+}
+
+esp_err_t auth_revoke_api_key(const char* name) {
+    if (!name) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (!g_auth_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+    int slot = find_api_key_by_name(name);
+    if (slot >= 0) {
+        remove_session(slot);
+    }
+    xSemaphoreGive(g_session_mutex);
+    if (slot < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    ESP_LOGI(TAG, "API key revoked: %s", name);
+    return save_api_keys();
+}
+
+int auth_list_api_keys(auth_api_key_info_t* keys, int max_keys) {
+    if (!keys || !g_auth_initialized) {
+        return 0;
+    }
+    
+    int count = 0;
+    xSemaphoreTake(g_session_mutex, portMAX_DELAY);
+    uint64_t now = auth_now_ms();
+    for (int i = 0; i < g_session_count && count < max_keys; i++) {
+        const session_entry_t* entry = &g_sessions[i];
+        if (entry->api_key) {
+            auth_api_key_info_t* info = &keys[count++];
+            snprintf(info->name, sizeof(info->name), "%s", entry->username);
+            info->used = entry->last_access_time != 0;
+            info->idle_seconds = info->used ? (uint32_t)((now - entry->last_access_time) / 1000) : 0;
+        }
+    }
+    xSemaphoreGive(g_session_mutex);
+    return count;
+}
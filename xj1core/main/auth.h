@@ -27,27 +27,68 @@
 extern "C" {
 #endif
 
-#define AUTH_SESSION_TIMEOUT_MS (30 * 60 * 1000)  // 30分钟会话超时
-#define AUTH_MAX_SESSIONS 5                        // 最大并发会话数
-#define AUTH_SESSION_ID_LENGTH 32                  // 会话ID长度
+#define AUTH_SESSION_TIMEOUT_DEFAULT_MS (30 * 60 * 1000)  // 读取不到timeouts.session_max_age时的会话超时
+#define AUTH_SESSION_WHEEL_SLOTS 256               // 过期时间轮槽数，必须是2的幂
+#define AUTH_SESSION_WHEEL_TICK_MS 1000            // 时间轮推进间隔，也是会话过期的判定精度
+#define AUTH_SESSION_ID_BYTES 16                   // 会话ID随机字节数
+#define AUTH_SESSION_ID_LENGTH (AUTH_SESSION_ID_BYTES * 2)  // 会话ID十六进制字符串长度
+#define AUTH_TOKEN_MAC_BYTES 16                    // 令牌中截断后的HMAC-SHA256字节数
+#define AUTH_TOKEN_LENGTH (1 + 8 + 8 + AUTH_TOKEN_MAC_BYTES * 2)  // 't'+签发时间+密钥代数+MAC，均为十六进制
+#define AUTH_CREDENTIAL_MAX_LENGTH AUTH_TOKEN_LENGTH       // 会话ID、令牌或API密钥的最大长度，调用者按此分配缓冲区
+#define AUTH_API_KEY_BYTES 16                      // API密钥随机字节数
+#define AUTH_API_KEY_LENGTH (1 + AUTH_API_KEY_BYTES * 2)  // 'k'+随机数，十六进制
+#define AUTH_API_KEY_NAME_MAX 31                   // API密钥名称最大长度
+#define AUTH_MAX_API_KEYS 8                        // API密钥数量上限，不占用max_sessions
+#define AUTH_PBKDF2_PREFIX "pbkdf2-sha256$"        // 密码哈希格式: pbkdf2-sha256$迭代次数$盐$哈希，盐和哈希为十六进制
+#define AUTH_PBKDF2_SALT_BYTES 16                  // 每次设置密码时随机生成的盐
+#define AUTH_PBKDF2_HASH_BYTES 32
+
+#define AUTH_LOGIN_BURST 5                         // 每个客户端可连续尝试登录的次数
+#define AUTH_LOGIN_REFILL_MS 12000                 // 每隔多久恢复一次尝试机会
+#define AUTH_LOGIN_LOCKOUT_THRESHOLD 5             // 连续失败达到此次数后开始锁定
+#define AUTH_LOGIN_LOCKOUT_BASE_MS 30000           // 首次锁定时长，之后每多失败一次翻倍
+#define AUTH_LOGIN_LOCKOUT_MAX_MS (15 * 60 * 1000) // 最长锁定时长
+#define AUTH_PERSIST_MAX_SESSIONS 16               // 重启后恢复的会话数上限，超出时保留最近访问的
+#define AUTH_PERSIST_NVS_INTERVAL_MS (60 * 1000)   // 会话增删后写入NVS的最短间隔
+#define AUTH_PERSIST_TOUCH_INTERVAL_MS (10 * 60 * 1000)  // 只有访问时间变化时写入NVS的最短间隔
+#define AUTH_PERSIST_POWERON_GRACE_MS (10 * 60 * 1000)   // 断电重启后恢复的会话最多再保留多久，期间访问则继续有效
+
+#define AUTH_THROTTLE_CLIENTS 16                   // 同时跟踪的客户端数，超出时替换最久未出现的
+#define AUTH_CLIENT_ADDR_BYTES 16                  // 客户端地址长度，IPv4使用IPv4映射的IPv6地址
 
 /**
  * @brief 会话信息结构体
  */
 typedef struct {
-    char session_id[AUTH_SESSION_ID_LENGTH + 1];
+    char session_id[AUTH_CREDENTIAL_MAX_LENGTH + 1];
     char username[32];
     uint64_t created_time;
     uint64_t last_access_time;
     bool is_valid;
 } auth_session_t;
 
+/**
+ * @brief API密钥信息
+ */
+typedef struct {
+    char name[AUTH_API_KEY_NAME_MAX + 1];
+    bool used;                  // 本次启动后是否使用过
+    uint32_t idle_seconds;      // 距最近一次使用的秒数，used为true时有效
+} auth_api_key_info_t;
+
 /**
  * @brief 初始化认证模块
  * @return ESP_OK成功，其他值失败
+ * @note 会话表按web_server.max_sessions分配，需在config_manager_init之后调用；
+ *       web_server.persist_sessions为1时恢复重启前的会话和令牌密钥
  */
 esp_err_t auth_init(void);
 
+/**
+ * @brief 释放认证模块，清除全部会话
+ */
+void auth_deinit(void);
+
 /**
  * @brief 计算字符串的SHA-256哈希值
  * @param input 输入字符串
@@ -61,6 +102,7 @@ esp_err_t auth_calculate_sha256(const char* input, char* output);
  * @param username 用户名
  * @param password 明文密码
  * @return true验证成功，false验证失败
+ * @note 保存的哈希为旧版无盐SHA-256或迭代次数与配置不同时，验证成功后按当前配置重新计算并保存
  */
 bool auth_verify_password(const char* username, const char* password);
 
@@ -77,21 +119,25 @@ esp_err_t auth_change_password(const char* username, const char* old_password, c
  * @brief 用户登录
  * @param username 用户名
  * @param password 密码(明文)
- * @param session_id 输出会话ID
+ * @param session_id 输出会话ID或令牌，缓冲区至少AUTH_CREDENTIAL_MAX_LENGTH + 1字节
  * @return ESP_OK成功，其他值失败
+ * @note web_server.stateless_sessions为1时签发无状态令牌：HMAC-SHA256签名覆盖用户名、签发时间和
+ *       密钥代数，不占用会话表，登录数量不受max_sessions限制。令牌从签发起经过会话超时
+ *       后过期，访问不会延长有效期
  */
 esp_err_t auth_login(const char* username, const char* password, char* session_id);
 
 /**
  * @brief 用户登出
- * @param session_id 会话ID
+ * @param session_id 会话ID或令牌
  * @return ESP_OK成功，其他值失败
+ * @note 无状态令牌无法单独吊销，登出只依靠客户端删除cookie；修改密码会使全部令牌失效
  */
 esp_err_t auth_logout(const char* session_id);
 
 /**
  * @brief 验证会话
- * @param session_id 会话ID
+ * @param session_id 会话ID、令牌或API密钥
  * @return true会话有效，false会话无效
  */
 bool auth_validate_session(const char* session_id);
@@ -105,8 +151,27 @@ bool auth_validate_session(const char* session_id);
 esp_err_t auth_get_session_info(const char* session_id, auth_session_t* session);
 
 /**
- * @brief 清理过期会话
+ * @brief 按写入预算把会话和令牌密钥保存到NVS，供断电重启后恢复
+ * @return ESP_OK已写入或暂不需要写入，其他值写入失败
+ * @note 由状态任务定期调用。登录后最多每AUTH_PERSIST_NVS_INTERVAL_MS写入一次，只有访问时间
+ *       变化时最多每AUTH_PERSIST_TOUCH_INTERVAL_MS写入一次；登出和修改密码不受写入预算限制，立即写入。
+ *       软件重启使用随时更新的RTC内存副本，不依赖NVS。
+ *       令牌模式下也在这里按会话超时周期轮换签名密钥
+ */
+esp_err_t auth_save_sessions(void);
+
+/**
+ * @brief 获取会话超时
+ * @return 会话超时(ms)，取自timeouts.session_max_age，修改配置后立即生效
+ * @note 会话空闲超过此时长后失效；令牌从签发起超过此时长后失效；也用作会话cookie的Max-Age
+ */
+uint32_t auth_get_session_timeout_ms(void);
+
+/**
+ * @brief 把过期时间轮推进到当前时刻，清理到期的会话
  * @return 清理的会话数量
+ * @note 有会话时内部定时器每AUTH_SESSION_WHEEL_TICK_MS调用一次，调用者不需要定期调用；
+ *       开销只与到期槽中的会话数有关，与会话总数无关
  */
 int auth_cleanup_expired_sessions(void);
 
@@ -117,6 +182,71 @@ int auth_cleanup_expired_sessions(void);
  */
 esp_err_t auth_generate_session_id(char* session_id);
 
+/**
+ * @brief 登录前检查客户端是否允许尝试，允许时消耗一次尝试机会
+ * @param client 客户端地址，AUTH_CLIENT_ADDR_BYTES字节
+ * @param retry_after_ms 输出被拒绝时需等待的毫秒数，可为NULL
+ * @return true允许，false请求过快或处于锁定期
+ * @note 每个客户端一个令牌桶，容量AUTH_LOGIN_BURST，每AUTH_LOGIN_REFILL_MS恢复一次；
+ *       应在读取请求体和计算密码哈希之前调用
+ */
+bool auth_login_throttle_allow(const uint8_t* client, uint32_t* retry_after_ms);
+
+/**
+ * @brief 记录客户端的登录结果
+ * @param client 客户端地址，AUTH_CLIENT_ADDR_BYTES字节
+ * @param success true登录成功，清除失败计数；false密码错误，连续失败过多时按指数增长锁定
+ */
+void auth_login_throttle_record(const uint8_t* client, bool success);
+
+/**
+ * @brief 从Cookie请求头中取出session_id的值
+ * @param cookie_header Cookie请求头，如"lang=zh; session_id=..."
+ * @param session_id 输出，缓冲区至少AUTH_CREDENTIAL_MAX_LENGTH + 1字节
+ * @return ESP_OK找到，ESP_ERR_NOT_FOUND没有session_id，ESP_ERR_INVALID_SIZE值超过AUTH_CREDENTIAL_MAX_LENGTH
+ * @note 按';'分隔的名值对逐个比较名称，不分配内存
+ */
+esp_err_t auth_parse_cookie(const char* cookie_header, char* session_id);
+
+/**
+ * @brief 从Authorization请求头中取出Bearer凭据
+ * @param authorization Authorization请求头，如"Bearer k0123..."
+ * @param credential 输出，缓冲区至少AUTH_CREDENTIAL_MAX_LENGTH + 1字节
+ * @return ESP_OK找到，ESP_ERR_NOT_FOUND不是Bearer方案，ESP_ERR_INVALID_SIZE凭据过长
+ */
+esp_err_t auth_parse_bearer(const char* authorization, char* credential);
+
+/**
+ * @brief 判断凭据是否为API密钥格式
+ */
+bool auth_is_api_key(const char* credential);
+
+/**
+ * @brief 为客户端创建API密钥
+ * @param name 密钥名称，1~AUTH_API_KEY_NAME_MAX个字符，不能与已有密钥重名
+ * @param api_key 输出密钥，缓冲区至少AUTH_API_KEY_LENGTH + 1字节
+ * @return ESP_OK成功，ESP_ERR_INVALID_ARG名称无效，ESP_ERR_INVALID_STATE名称已存在，
+ *         ESP_ERR_NO_MEM已有AUTH_MAX_API_KEYS个密钥，其他值写入NVS失败
+ * @note 密钥只在创建时返回一次。会话表和NVS只保存密钥的SHA-256摘要，验证与会话ID同样是O(1)查找；
+ *       密钥不会过期，重启后仍然有效，与web_server.persist_sessions无关
+ */
+esp_err_t auth_create_api_key(const char* name, char* api_key);
+
+/**
+ * @brief 吊销API密钥
+ * @param name 密钥名称
+ * @return ESP_OK成功，ESP_ERR_NOT_FOUND不存在，其他值写入NVS失败(本次启动内已失效)
+ */
+esp_err_t auth_revoke_api_key(const char* name);
+
+/**
+ * @brief 列出API密钥
+ * @param keys 输出数组
+ * @param max_keys 数组长度
+ * @return 密钥数量
+ */
+int auth_list_api_keys(auth_api_key_info_t* keys, int max_keys);
+
 #ifdef __cplusplus
 }
 #endif
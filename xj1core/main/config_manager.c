@@ -21,225 +21,564 @@
 #include "esp_log.h"
 #include "esp_spiffs.h"
 #include "esp_vfs.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_attr.h"
+#include "esp_rom_crc.h"
+#include "nvs.h"
+#include "cJSON.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CONFIG_NVS_NAMESPACE "xj1_config"
+#define CONFIG_SNAPSHOT_KEY "snapshot"
+#define CONFIG_SNAPSHOT_MAGIC 0x46434A58    // "XJCF"
+#define CONFIG_SNAPSHOT_VERSION 2           // system_config_t含义变化但大小不变时必须加1
+
+/**
+ * @brief NVS中的配置快照，启动时直接使用，跳过INI解析
+ * @note 覆盖层文件的大小和CRC32与快照记录的不同时（重新烧写SPIFFS、手工修改或从临时文件恢复），
+ *       快照失效，重新从INI导入
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;                          // sizeof(system_config_t)
+    uint32_t embedded_crc;                  // 生成快照时嵌入config.ini的CRC32
+    uint32_t overlay_size;                  // 生成快照时覆盖层文件的大小，没有文件时为0
+    uint32_t overlay_crc;                   // 生成快照时覆盖层文件的CRC32，没有文件时为0
+    system_config_t config;
+    uint32_t crc;                           // 以上字段的CRC32
+} config_snapshot_t;
+
+#define CONFIG_RTC_CACHE_MAGIC 0x43524A58   // "XJRC"
+
+/**
+ * @brief RTC_NOINIT内存中的配置缓存，软件重启后连NVS也不用读取
+ * @note 内容与NVS快照一致：配置写入文件后更新，写文件前失效
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;                          // sizeof(system_config_t)
+    uint32_t embedded_crc;                  // 生成缓存时嵌入config.ini的CRC32
+    uint32_t generation;                    // 重启前的配置代数，重启后继续使用
+    system_config_t config;
+    uint32_t crc;                           // 以上字段的CRC32
+} config_rtc_cache_t;
+
+static RTC_NOINIT_ATTR config_rtc_cache_t s_rtc_cache;
 
 // 外部引用的嵌入config.ini文件内容
 extern const char config_ini_start[] asm("_binary_config_ini_start");
 extern const char config_ini_end[] asm("_binary_config_ini_end");
 
 static const char *TAG = "config_manager";
-static ini_config_t *g_ini_config = NULL;
-static system_config_t g_system_config = {0};
+static ini_config_t *g_base_ini = NULL;          // 基础层：嵌入flash的config.ini，只读
+static ini_config_t *g_overlay_ini = NULL;       // 用户覆盖层：只含与基础层不同的键，保存在CONFIG_FILE_PATH
 static bool g_config_loaded = false;
+static bool g_ini_loaded = false;                // 两层INI已加载，由快照启动时延迟到第一次写入
+static bool g_spiffs_mounted = false;
+static SemaphoreHandle_t g_config_mutex = NULL;  // 串行化写者（发布新快照）和脏标记
+static SemaphoreHandle_t g_flush_mutex = NULL;   // 串行化INI更新和文件写入
+static TaskHandle_t g_flush_task_handle = NULL;
+static uint32_t g_dirty_sections = 0;            // 尚未写入文件的配置段(config_section_t)
+static system_config_t g_flush_snapshot;         // 写入时使用的配置快照，受g_flush_mutex保护
 
 /**
- * @brief 将嵌入的config.ini复制到SPIFFS
+ * @brief 配置快照槽位
+ * @note 发布后内容不再修改，读者持有期间refs不为0，写者只会复用refs为0且不是当前快照的槽位
  */
-static esp_err_t copy_embedded_config_to_spiffs(void) {
-    // 计算嵌入文件的大小
-    size_t config_size = config_ini_end - config_ini_start;
+typedef struct {
+    system_config_t config;
+    uint32_t generation;
+    atomic_uint refs;
+} config_slot_t;
+
+static config_slot_t g_config_slots[CONFIG_SNAPSHOT_SLOTS];
+static config_slot_t* _Atomic g_current_slot = NULL;  // 当前发布的快照
+static uint32_t g_generation = 0;                     // 最近一次发布的代数，受g_config_mutex保护
+
+/**
+ * @brief 配置变化订阅者
+ */
+typedef struct {
+    uint32_t sections;
+    config_change_cb_t cb;
+    void* arg;
+} config_subscriber_t;
+
+static config_subscriber_t g_subscribers[CONFIG_MAX_SUBSCRIBERS];  // 受g_config_mutex保护
+
+/**
+ * @brief 配置段在system_config_t中的位置，用于比较和标记脏段
+ */
+static const struct {
+    uint32_t section;
+    size_t offset;
+    size_t size;
+} s_section_layout[] = {
+    { CONFIG_SECTION_WIFI_AP,    offsetof(system_config_t, wifi_ap),    sizeof(xj1_wifi_ap_config_t) },
+    { CONFIG_SECTION_WIFI_STA,   offsetof(system_config_t, wifi_sta),   sizeof(xj1_wifi_sta_config_t) },
+    { CONFIG_SECTION_ETHERNET,   offsetof(system_config_t, ethernet),   sizeof(ethernet_config_t) },
+    { CONFIG_SECTION_AUTH,       offsetof(system_config_t, auth),       sizeof(auth_config_t) },
+    { CONFIG_SECTION_BLUETOOTH,  offsetof(system_config_t, bluetooth),  sizeof(bluetooth_config_t) },
+    { CONFIG_SECTION_MQTT,       offsetof(system_config_t, mqtt),       sizeof(mqtt_config_t) },
+    { CONFIG_SECTION_WEB_SERVER, offsetof(system_config_t, web_server), sizeof(web_server_config_t) },
+    { CONFIG_SECTION_TIMEOUTS,   offsetof(system_config_t, timeouts),   sizeof(timeout_config_t) },
+    { CONFIG_SECTION_INTERVALS,  offsetof(system_config_t, intervals),  sizeof(interval_config_t) },
+};
+
+/**
+ * @brief 配置字段表
+ * @note 默认值、INI加载/保存和JSON导出都由这一张表生成，增加配置项只需在这里加一行。
+ *       CONFIG_STRING(段标志, 段名, 键名, 默认值, 标志)
+ *       CONFIG_INT(段标志, 段名, 键名, 默认值, 最小值, 最大值, 标志)
+ *       段名与system_config_t的成员名相同；整数范围用于加载时检查，避免错误的间隔或超时传入vTaskDelay等调用
+ */
+#define CONFIG_SCHEMA(CONFIG_STRING, CONFIG_INT) \
+    CONFIG_STRING(WIFI_AP,    wifi_ap,    ssid,                       "Sparkriver-AP-01",         0) \
+    CONFIG_STRING(WIFI_AP,    wifi_ap,    ip,                         "192.168.5.1",              0) \
+    CONFIG_STRING(WIFI_AP,    wifi_ap,    password,                   "12345678",                 0) \
+    CONFIG_STRING(WIFI_STA,   wifi_sta,   ssid,                       "fengqi-2G",                0) \
+    CONFIG_STRING(WIFI_STA,   wifi_sta,   password,                   "Xiaoying168",              0) \
+    CONFIG_STRING(ETHERNET,   ethernet,   ip,                         "192.168.1.40",             0) \
+    CONFIG_STRING(ETHERNET,   ethernet,   netmask,                    "255.255.255.0",            0) \
+    CONFIG_STRING(ETHERNET,   ethernet,   dns,                        "8.8.8.8",                  0) \
+    CONFIG_STRING(ETHERNET,   ethernet,   gateway,                    "192.168.1.1",              0) \
+    CONFIG_STRING(AUTH,       auth,       username,                   "admin",                    CONFIG_FIELD_PRIVATE) \
+    /* 默认密码123456的SHA-256哈希值，首次登录成功后迁移为加盐的PBKDF2哈希 */ \
+    CONFIG_STRING(AUTH,       auth,       password_hash,              "8d969eef6ecad3c29a3a629280e686cf0c3f5d5a86aff3ca12020c923adc6c92", CONFIG_FIELD_PRIVATE) \
+    CONFIG_INT(   AUTH,       auth,       pbkdf2_iterations,          10000, 1000, 1000000,       CONFIG_FIELD_PRIVATE) \
+    CONFIG_STRING(BLUETOOTH,  bluetooth,  device_name,                "Sparkriver-Ble-01",        0) \
+    CONFIG_STRING(BLUETOOTH,  bluetooth,  pairing_password,           "123456",                   0) \
+    CONFIG_STRING(MQTT,       mqtt,       broker_host,                "localhost",                0) \
+    CONFIG_INT(   MQTT,       mqtt,       broker_port,                1883,  1,    65535,         0) \
+    CONFIG_STRING(MQTT,       mqtt,       client_id,                  "xj1core-student-01",       0) \
+    CONFIG_STRING(MQTT,       mqtt,       default_topic,              "xj1core/data/receive",     0) \
+    CONFIG_INT(   MQTT,       mqtt,       keepalive,                  60,    5,    3600,          0) \
+    CONFIG_STRING(MQTT,       mqtt,       topic_student_to_teacher,   "xj1core/student/message",  0) \
+    CONFIG_STRING(MQTT,       mqtt,       topic_teacher_to_student,   "xj1cloud/teacher/message", 0) \
+    CONFIG_STRING(MQTT,       mqtt,       topic_student_heartbeat,    "xj1core/heartbeat",        0) \
+    CONFIG_STRING(MQTT,       mqtt,       topic_student_status,       "xj1core/status",           0) \
+    CONFIG_INT(   WEB_SERVER, web_server, port,                       80,    1,    65535,         0) \
+    CONFIG_INT(   WEB_SERVER, web_server, max_sessions,               5,     1,    1024,          0) \
+    CONFIG_INT(   WEB_SERVER, web_server, stateless_sessions,         0,     0,    1,             0) \
+    CONFIG_INT(   WEB_SERVER, web_server, persist_sessions,           1,     0,    1,             0) \
+    CONFIG_INT(   TIMEOUTS,   timeouts,   mqtt_reconnect_timeout,     10000, 1000, 600000,        0) \
+    CONFIG_INT(   TIMEOUTS,   timeouts,   mqtt_connect_timeout,       15000, 1000, 600000,        0) \
+    CONFIG_INT(   TIMEOUTS,   timeouts,   mqtt_refresh_connection,    30000, 1000, 3600000,       0) \
+    CONFIG_INT(   TIMEOUTS,   timeouts,   wifi_scan_timeout,          5000,  1000, 60000,         0) \
+    CONFIG_INT(   TIMEOUTS,   timeouts,   wifi_scan_advanced_timeout, 10000, 1000, 120000,        0) \
+    CONFIG_INT(   TIMEOUTS,   timeouts,   session_max_age,            1800,  60,   604800,        0) \
+    CONFIG_INT(   INTERVALS,  intervals,  status_update_interval,     5000,  500,  3600000,       0) \
+    CONFIG_INT(   INTERVALS,  intervals,  heartbeat_interval,         5000,  1000, 3600000,       0) \
+    CONFIG_INT(   INTERVALS,  intervals,  monitor_check_interval,     10000, 1000, 3600000,       0)
+
+#define CONFIG_FIELD_PRIVATE (1 << 0)   // 不导出到JSON（如密码哈希）
+
+/**
+ * @brief 配置字段类型
+ */
+typedef enum {
+    CONFIG_FIELD_STRING,
+    CONFIG_FIELD_INT,
+} config_field_type_t;
+
+/**
+ * @brief 配置字段描述，由CONFIG_SCHEMA生成
+ */
+typedef struct {
+    const char* section;
+    const char* key;
+    uint16_t offset;                    // 在system_config_t中的偏移
+    uint16_t size;                      // 字符串缓冲区大小
+    uint16_t section_flag;              // config_section_t
+    uint8_t type;                       // config_field_type_t
+    uint8_t flags;                      // CONFIG_FIELD_*
+    const char* default_string;
+    int default_int;
+    int min;                            // 整数取值范围
+    int max;
+} config_field_t;
+
+#define CONFIG_FIELD_SIZE(group, key) sizeof(((system_config_t*)0)->group.key)
+
+#define CONFIG_STRING_FIELD(flag, group, key, def, field_flags) \
+    { #group, #key, offsetof(system_config_t, group.key), CONFIG_FIELD_SIZE(group, key), \
+      CONFIG_SECTION_##flag, CONFIG_FIELD_STRING, field_flags, def, 0, 0, 0 },
+#define CONFIG_INT_FIELD(flag, group, key, def, min, max, field_flags) \
+    { #group, #key, offsetof(system_config_t, group.key), CONFIG_FIELD_SIZE(group, key), \
+      CONFIG_SECTION_##flag, CONFIG_FIELD_INT, field_flags, NULL, def, min, max },
+
+static const config_field_t s_config_fields[] = {
+    CONFIG_SCHEMA(CONFIG_STRING_FIELD, CONFIG_INT_FIELD)
+};
+
+#define CONFIG_STRING_SPEC(flag, group, key, def, field_flags)
+#define CONFIG_INT_SPEC(flag, group, key, def, min, max, field_flags) \
+    { #group, #key, INI_VALUE_INT, min, max, def },
+
+// 整数字段的取值范围，超出范围的值在加载时警告一次并使用默认值
+static const ini_value_spec_t s_value_specs[] = {
+    CONFIG_SCHEMA(CONFIG_STRING_SPEC, CONFIG_INT_SPEC)
+};
+
+#define CONFIG_FIELD_COUNT (sizeof(s_config_fields) / sizeof(s_config_fields[0]))
+
+/**
+ * @brief 获取字段在配置结构体中的地址
+ */
+static inline void* field_ptr(system_config_t* config, const config_field_t* field) {
+    return (uint8_t*)config + field->offset;
+}
+
+static inline const void* field_cptr(const system_config_t* config, const config_field_t* field) {
+    return (const uint8_t*)config + field->offset;
+}
+
+/**
+ * @brief 加载默认配置
+ */
+static void load_default_config(system_config_t* config) {
+    memset(config, 0, sizeof(system_config_t));
+    for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+        const config_field_t* field = &s_config_fields[i];
+        if (field->type == CONFIG_FIELD_STRING) {
+            snprintf(field_ptr(config, field), field->size, "%s", field->default_string);
+        } else {
+            *(int*)field_ptr(config, field) = field->default_int;
+        }
+    }
+}
+
+/**
+ * @brief 用一层INI中存在的键覆盖配置结构体中的值
+ */
+static void load_layer(ini_config_t* ini, system_config_t* config) {
+    for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+        const config_field_t* field = &s_config_fields[i];
+        if (!ini_config_has_key(ini, field->section, field->key)) {
+            continue;
+        }
+        if (field->type == CONFIG_FIELD_STRING) {
+            ini_config_copy_string(ini, field->section, field->key,
+                                   field_ptr(config, field), field->size, field->default_string);
+        } else {
+            *(int*)field_ptr(config, field) = ini_config_get_int(ini, field->section, field->key,
+                                                                 field->default_int);
+        }
+    }
+}
+
+/**
+ * @brief 加载基础层配置：字段表默认值，再由嵌入的config.ini覆盖
+ */
+static void load_base_config(system_config_t* config) {
+    load_default_config(config);
+    load_layer(g_base_ini, config);
+}
+
+/**
+ * @brief 按层加载系统配置：覆盖层优先，其次基础层，都没有的项使用默认值
+ */
+static void load_from_ini(system_config_t* config) {
+    int64_t start_us = esp_timer_get_time();
     
-    ESP_LOGI(TAG, "Copying embedded config.ini to SPIFFS (%d bytes)", config_size);
-    ESP_LOGI(TAG, "Embedded config start: %p, end: %p", config_ini_start, config_ini_end);
+    load_base_config(config);
+    load_layer(g_overlay_ini, config);
     
-    // 检查嵌入文件是否有效
-    if (config_size == 0 || config_size > 10000) {
-        ESP_LOGE(TAG, "Invalid embedded config size: %d bytes", config_size);
-        return ESP_FAIL;
+    // 记录一次完整加载的耗时，便于对比查找性能
+    ESP_LOGI(TAG, "load_from_ini completed in %lld us (%d user overrides)",
+             esp_timer_get_time() - start_us, ini_config_get_item_count(g_overlay_ini));
+}
+
+/**
+ * @brief 比较两份配置中的一个字段
+ */
+static bool field_equals(const system_config_t* a, const system_config_t* b, const config_field_t* field) {
+    if (field->type == CONFIG_FIELD_STRING) {
+        return strcmp(field_cptr(a, field), field_cptr(b, field)) == 0;
     }
-    
-    // 创建文件并写入内容
-    FILE* file = fopen(CONFIG_FILE_PATH, "w");
-    if (!file) {
-        ESP_LOGE(TAG, "Failed to create config file in SPIFFS");
-        return ESP_FAIL;
+    return *(const int*)field_cptr(a, field) == *(const int*)field_cptr(b, field);
+}
+
+/**
+ * @brief 把配置中与基础层不同的字段写入覆盖层，与基础层相同的字段从覆盖层删除
+ * @param sections 需要更新的配置段(config_section_t按位或)
+ */
+static esp_err_t save_to_ini(const system_config_t* config, uint32_t sections) {
+    system_config_t* base = malloc(sizeof(system_config_t));
+    if (!base) {
+        return ESP_ERR_NO_MEM;
     }
+    load_base_config(base);
     
-    size_t written = fwrite(config_ini_start, 1, config_size, file);
-    fclose(file);
-    
-    if (written != config_size) {
-        ESP_LOGE(TAG, "Failed to write complete config file (wrote %d of %d bytes)", written, config_size);
-        return ESP_FAIL;
+    esp_err_t ret = ESP_OK;
+    for (size_t i = 0; i < CONFIG_FIELD_COUNT && ret == ESP_OK; i++) {
+        const config_field_t* field = &s_config_fields[i];
+        if (!(sections & field->section_flag)) {
+            continue;
+        }
+        
+        if (field_equals(config, base, field)) {
+            ret = ini_config_remove_key(g_overlay_ini, field->section, field->key);
+            if (ret == ESP_ERR_NOT_FOUND) {
+                ret = ESP_OK;
+            }
+        } else if (field->type == CONFIG_FIELD_STRING) {
+            ret = ini_config_set_string(g_overlay_ini, field->section, field->key, field_cptr(config, field));
+        } else {
+            ret = ini_config_set_int(g_overlay_ini, field->section, field->key, *(const int*)field_cptr(config, field));
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set [%s] %s: %s", field->section, field->key, esp_err_to_name(ret));
+        }
     }
     
-    ESP_LOGI(TAG, "Successfully copied embedded config.ini to SPIFFS");
-    return ESP_OK;
+    free(base);
+    return ret;
 }
 
 /**
- * @brief 加载默认配置
- */
-static void load_default_config(system_config_t* config) {
-    // WiFi AP默认配置
-    strcpy(config->wifi_ap.ssid, "Sparkriver-AP-01");
-    strcpy(config->wifi_ap.ip, "192.168.5.1");
-    strcpy(config->wifi_ap.password, "12345678");
-    
-    // WiFi STA默认配置
-    strcpy(config->wifi_sta.ssid, "fengqi-2G");
-    strcpy(config->wifi_sta.password, "Xiaoying168");
-    
-    // 以太网默认配置
-    strcpy(config->ethernet.ip, "192.168.1.40");
-    strcpy(config->ethernet.netmask, "255.255.255.0");
-    strcpy(config->ethernet.dns, "8.8.8.8");
-    strcpy(config->ethernet.gateway, "192.168.1.1");
-    
-    // 认证默认配置
-    strcpy(config->auth.username, "admin");
-    // 默认密码123456的SHA-256哈希值
-    strcpy(config->auth.password_hash, "8d969eef6ecad3c29a3a629280e686cf0c3f5d5a86aff3ca12020c923adc6c92");
-    
-    // 蓝牙默认配置
-    strcpy(config->bluetooth.device_name, "Sparkriver-Ble-01");
-    strcpy(config->bluetooth.pairing_password, "123456");
-    
-    // MQTT默认配置
-    strcpy(config->mqtt.broker_host, "localhost");
-    config->mqtt.broker_port = 1883;
-    strcpy(config->mqtt.client_id, "xj1core-student-01");
-    strcpy(config->mqtt.default_topic, "xj1core/data/receive");
-    config->mqtt.keepalive = 60;
-    strcpy(config->mqtt.topic_student_to_teacher, "xj1core/student/message");
-    strcpy(config->mqtt.topic_teacher_to_student, "xj1cloud/teacher/message");
-    strcpy(config->mqtt.topic_student_heartbeat, "xj1core/heartbeat");
-    strcpy(config->mqtt.topic_student_status, "xj1core/status");
-    
-    // Web服务器默认配置
-    config->web_server.port = 80;
-    
-    // 超时配置默认值
-    config->timeouts.mqtt_reconnect_timeout = 10000;
-    config->timeouts.mqtt_connect_timeout = 15000;
-    config->timeouts.mqtt_refresh_connection = 30000;
-    config->timeouts.wifi_scan_timeout = 5000;
-    config->timeouts.wifi_scan_advanced_timeout = 10000;
-    config->timeouts.session_max_age = 1800;
-    
-    // 时间间隔配置默认值
-    config->intervals.status_update_interval = 5000;
-    config->intervals.heartbeat_interval = 5000;
-    config->intervals.monitor_check_interval = 10000;
-    
-    ESP_LOGI(TAG, "Default configuration loaded");
-}
-
-/**
- * @brief 从INI配置加载到系统配置结构体
+ * @brief 删除覆盖层中与基础层相同的键
+ * @note 旧版本把完整配置复制到SPIFFS，加载这样的文件后只保留真正修改过的键
+ * @return 删除的键数
  */
-static void load_from_ini(system_config_t* config) {
-    if (!g_ini_config) {
-        ESP_LOGE(TAG, "INI config not initialized");
-        return;
+static int prune_overlay(void) {
+    // 先按原始字符串比较，字段表之外的键也能去掉；再按字段比较，去掉写法不同但值相同的键
+    int pruned = ini_config_remove_equal(g_overlay_ini, g_base_ini);
+    
+    system_config_t* base = malloc(sizeof(system_config_t));
+    system_config_t* merged = malloc(sizeof(system_config_t));
+    
+    if (base && merged) {
+        load_base_config(base);
+        memcpy(merged, base, sizeof(system_config_t));
+        load_layer(g_overlay_ini, merged);
+        for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+            const config_field_t* field = &s_config_fields[i];
+            if (field_equals(merged, base, field) &&
+                ini_config_remove_key(g_overlay_ini, field->section, field->key) == ESP_OK) {
+                pruned++;
+            }
+        }
     }
     
-    // WiFi AP配置
-    strcpy(config->wifi_ap.ssid, ini_config_get_string(g_ini_config, "wifi_ap", "ssid", "Sparkriver-AP-01"));
-    strcpy(config->wifi_ap.ip, ini_config_get_string(g_ini_config, "wifi_ap", "ip", "192.168.5.1"));
-    strcpy(config->wifi_ap.password, ini_config_get_string(g_ini_config, "wifi_ap", "password", "12345678"));
-    
-    // WiFi STA配置
-    strcpy(config->wifi_sta.ssid, ini_config_get_string(g_ini_config, "wifi_sta", "ssid", "fengqi-2G"));
-    strcpy(config->wifi_sta.password, ini_config_get_string(g_ini_config, "wifi_sta", "password", "Xiaoying168"));
-    
-    // 以太网配置
-    strcpy(config->ethernet.ip, ini_config_get_string(g_ini_config, "ethernet", "ip", "192.168.1.40"));
-    strcpy(config->ethernet.netmask, ini_config_get_string(g_ini_config, "ethernet", "netmask", "255.255.255.0"));
-    strcpy(config->ethernet.dns, ini_config_get_string(g_ini_config, "ethernet", "dns", "8.8.8.8"));
-    strcpy(config->ethernet.gateway, ini_config_get_string(g_ini_config, "ethernet", "gateway", "192.168.1.1"));
-    
-    // 认证配置
-    strcpy(config->auth.username, ini_config_get_string(g_ini_config, "auth", "username", "admin"));
-    strcpy(config->auth.password_hash, ini_config_get_string(g_ini_config, "auth", "password_hash", 
-           "8d969eef6ecad3c29a3a629280e686cf0c3f5d5a86aff3ca12020c923adc6c92"));
-    
-    // 蓝牙配置
-    strcpy(config->bluetooth.device_name, ini_config_get_string(g_ini_config, "bluetooth", "device_name", "Sparkriver-Ble-01"));
-    strcpy(config->bluetooth.pairing_password, ini_config_get_string(g_ini_config, "bluetooth", "pairing_password", "123456"));
-    
-    // MQTT配置
-    strcpy(config->mqtt.broker_host, ini_config_get_string(g_ini_config, "mqtt", "broker_host", "localhost"));
-    config->mqtt.broker_port = ini_config_get_int(g_ini_config, "mqtt", "broker_port", 1883);
-    strcpy(config->mqtt.client_id, ini_config_get_string(g_ini_config, "mqtt", "client_id", "xj1core-student-01"));
-    strcpy(config->mqtt.default_topic, ini_config_get_string(g_ini_config, "mqtt", "default_topic", "xj1core/data/receive"));
-    config->mqtt.keepalive = ini_config_get_int(g_ini_config, "mqtt", "keepalive", 60);
-    strcpy(config->mqtt.topic_student_to_teacher, ini_config_get_string(g_ini_config, "mqtt", "topic_student_to_teacher", "xj1core/student/message"));
-    strcpy(config->mqtt.topic_teacher_to_student, ini_config_get_string(g_ini_config, "mqtt", "topic_teacher_to_student", "xj1cloud/teacher/message"));
-    strcpy(config->mqtt.topic_student_heartbeat, ini_config_get_string(g_ini_config, "mqtt", "topic_student_heartbeat", "xj1core/heartbeat"));
-    strcpy(config->mqtt.topic_student_status, ini_config_get_string(g_ini_config, "mqtt", "topic_student_status", "xj1core/status"));
-    
-    // Web服务器配置
-    config->web_server.port = ini_config_get_int(g_ini_config, "web_server", "port", 80);
-    
-    // 超时配置
-    config->timeouts.mqtt_reconnect_timeout = ini_config_get_int(g_ini_config, "timeouts", "mqtt_reconnect_timeout", 10000);
-    config->timeouts.mqtt_connect_timeout = ini_config_get_int(g_ini_config, "timeouts", "mqtt_connect_timeout", 15000);
-    config->timeouts.mqtt_refresh_connection = ini_config_get_int(g_ini_config, "timeouts", "mqtt_refresh_connection", 30000);
-    config->timeouts.wifi_scan_timeout = ini_config_get_int(g_ini_config, "timeouts", "wifi_scan_timeout", 5000);
-    config->timeouts.wifi_scan_advanced_timeout = ini_config_get_int(g_ini_config, "timeouts", "wifi_scan_advanced_timeout", 10000);
-    config->timeouts.session_max_age = ini_config_get_int(g_ini_config, "timeouts", "session_max_age", 1800);
-    
-    // 时间间隔配置
-    config->intervals.status_update_interval = ini_config_get_int(g_ini_config, "intervals", "status_update_interval", 5000);
-    config->intervals.heartbeat_interval = ini_config_get_int(g_ini_config, "intervals", "heartbeat_interval", 5000);
-    config->intervals.monitor_check_interval = ini_config_get_int(g_ini_config, "intervals", "monitor_check_interval", 10000);
-}
-
-/**
- * @brief 从系统配置结构体保存到INI配置
- */
-static esp_err_t save_to_ini(const system_config_t* config) {
-    if (!g_ini_config) {
-        ESP_LOGE(TAG, "INI config not initialized");
-        return ESP_ERR_INVALID_STATE;
-    }
+    free(base);
+    free(merged);
+    return pruned;
+}
+
+/**
+ * @brief 从SPIFFS加载覆盖层文件
+ * @note 正式文件缺失或校验失败时尝试上次保存留下的完整临时文件，成功后将其重命名为正式文件
+ * @return ESP_OK成功，ESP_ERR_NOT_FOUND没有可用的覆盖层文件，其他值失败
+ */
+static esp_err_t load_from_spiffs(void) {
+    struct stat st;
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
     
-    // WiFi AP配置
-    ini_config_set_string(g_ini_config, "wifi_ap", "ssid", config->wifi_ap.ssid);
-    ini_config_set_string(g_ini_config, "wifi_ap", "ip", config->wifi_ap.ip);
-    ini_config_set_string(g_ini_config, "wifi_ap", "password", config->wifi_ap.password);
+    if (stat(CONFIG_FILE_PATH, &st) == 0) {
+        ESP_LOGI(TAG, "Attempting to load config from: %s", CONFIG_FILE_PATH);
+        ret = ini_config_load_from_file(g_overlay_ini, CONFIG_FILE_PATH);
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "Config file loaded successfully from SPIFFS");
+            return ESP_OK;
+        }
+        ESP_LOGW(TAG, "Failed to load config file from SPIFFS (error: %s)", esp_err_to_name(ret));
+    }
     
-    // WiFi STA配置
-    ini_config_set_string(g_ini_config, "wifi_sta", "ssid", config->wifi_sta.ssid);
-    ini_config_set_string(g_ini_config, "wifi_sta", "password", config->wifi_sta.password);
+    // 保存过程中断电：临时文件已完整写入但还没替换正式文件
+    const char* tmp_path = CONFIG_FILE_PATH INI_SAVE_TMP_SUFFIX;
+    if (stat(tmp_path, &st) != 0) {
+        return ret;
+    }
     
-    // 以太网配置
-    ini_config_set_string(g_ini_config, "ethernet", "ip", config->ethernet.ip);
-    ini_config_set_string(g_ini_config, "ethernet", "netmask", config->ethernet.netmask);
-    ini_config_set_string(g_ini_config, "ethernet", "dns", config->ethernet.dns);
-    ini_config_set_string(g_ini_config, "ethernet", "gateway", config->ethernet.gateway);
+    ESP_LOGW(TAG, "Found interrupted save, attempting to recover from: %s", tmp_path);
+    // 临时文件一定由ini_config_save_to_file写入，必须带校验行，缺少时说明没写完
+    esp_err_t tmp_ret = ini_config_load_from_file_verified(g_overlay_ini, tmp_path);
+    if (tmp_ret != ESP_OK) {
+        // 临时文件本身没写完，丢弃
+        ESP_LOGW(TAG, "Temporary config file is incomplete (error: %s), discarding", esp_err_to_name(tmp_ret));
+        unlink(tmp_path);
+        return ret;
+    }
     
-    // 认证配置
-    ini_config_set_string(g_ini_config, "auth", "username", config->auth.username);
-    ini_config_set_string(g_ini_config, "auth", "password_hash", config->auth.password_hash);
+    unlink(CONFIG_FILE_PATH);
+    if (rename(tmp_path, CONFIG_FILE_PATH) != 0) {
+        ESP_LOGW(TAG, "Failed to move recovered config into place, will retry on next save");
+    }
+    ESP_LOGI(TAG, "Config recovered from interrupted save");
+    return ESP_OK;
+}
+
+/**
+ * @brief 将覆盖层写入SPIFFS并记录耗时，覆盖层为空时删除文件
+ * @return ESP_OK成功，其他值失败
+ */
+static esp_err_t write_config_file(void) {
+    if (ini_config_get_item_count(g_overlay_ini) == 0) {
+        unlink(CONFIG_FILE_PATH INI_SAVE_TMP_SUFFIX);
+        if (unlink(CONFIG_FILE_PATH) == 0) {
+            ESP_LOGI(TAG, "No user overrides left, removed %s", CONFIG_FILE_PATH);
+        }
+        return ESP_OK;
+    }
     
-    // 蓝牙配置
-    ini_config_set_string(g_ini_config, "bluetooth", "device_name", config->bluetooth.device_name);
-    ini_config_set_string(g_ini_config, "bluetooth", "pairing_password", config->bluetooth.pairing_password);
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = ini_config_save_to_file(g_overlay_ini, CONFIG_FILE_PATH);
+    ESP_LOGI(TAG, "Config file write took %lld us", esp_timer_get_time() - start_us);
+    return ret;
+}
+
+/**
+ * @brief 通知后台任务有待写入的修改
+ */
+static void schedule_flush(void) {
+    if (g_flush_task_handle) {
+        xTaskNotifyGive(g_flush_task_handle);
+    }
+}
+
+/**
+ * @brief 取得一个空闲槽位并复制当前快照，调用者必须持有g_config_mutex
+ * @note 所有旧槽位都被读者持有时等待读者释放
+ */
+static config_slot_t* begin_update(void) {
+    config_slot_t* current = atomic_load(&g_current_slot);
+    
+    while (1) {
+        for (int i = 0; i < CONFIG_SNAPSHOT_SLOTS; i++) {
+            config_slot_t* slot = &g_config_slots[i];
+            if (slot != current && atomic_load(&slot->refs) == 0) {
+                if (current) {
+                    memcpy(&slot->config, &current->config, sizeof(system_config_t));
+                }
+                return slot;
+            }
+        }
+        ESP_LOGW(TAG, "All config snapshots are held by readers, waiting");
+        vTaskDelay(1);
+    }
+}
+
+/**
+ * @brief 发布新快照，之后的读者将看到新内容，调用者必须持有g_config_mutex
+ */
+static void publish_update(config_slot_t* slot) {
+    slot->generation = ++g_generation;
+    atomic_store(&g_current_slot, slot);
+}
+
+/**
+ * @brief 通知订阅了变化配置段的模块
+ * @note 在g_config_mutex之外调用，回调中可以读写配置；回调拿到的是通知时的最新快照，
+ *       多个写者的通知顺序交错时，订阅者最后收到的仍是最新配置
+ */
+static void notify_subscribers(uint32_t changed) {
+    config_subscriber_t subscribers[CONFIG_MAX_SUBSCRIBERS];
+    int count = 0;
+    
+    xSemaphoreTake(g_config_mutex, portMAX_DELAY);
+    for (int i = 0; i < CONFIG_MAX_SUBSCRIBERS; i++) {
+        if (g_subscribers[i].cb && (g_subscribers[i].sections & changed)) {
+            subscribers[count++] = g_subscribers[i];
+        }
+    }
+    xSemaphoreGive(g_config_mutex);
     
-    // MQTT配置
-    ini_config_set_string(g_ini_config, "mqtt", "broker_host", config->mqtt.broker_host);
-    ini_config_set_int(g_ini_config, "mqtt", "broker_port", config->mqtt.broker_port);
-    ini_config_set_string(g_ini_config, "mqtt", "client_id", config->mqtt.client_id);
-    ini_config_set_string(g_ini_config, "mqtt", "default_topic", config->mqtt.default_topic);
-    ini_config_set_int(g_ini_config, "mqtt", "keepalive", config->mqtt.keepalive);
-    ini_config_set_string(g_ini_config, "mqtt", "topic_student_to_teacher", config->mqtt.topic_student_to_teacher);
-    ini_config_set_string(g_ini_config, "mqtt", "topic_teacher_to_student", config->mqtt.topic_teacher_to_student);
-    ini_config_set_string(g_ini_config, "mqtt", "topic_student_heartbeat", config->mqtt.topic_student_heartbeat);
-    ini_config_set_string(g_ini_config, "mqtt", "topic_student_status", config->mqtt.topic_student_status);
+    if (count == 0) {
+        return;
+    }
     
-    // Web服务器配置
-    ini_config_set_int(g_ini_config, "web_server", "port", config->web_server.port);
+    const system_config_t* config = config_manager_acquire(NULL);
+    for (int i = 0; i < count; i++) {
+        subscribers[i].cb(subscribers[i].sections & changed, config, subscribers[i].arg);
+    }
+    config_manager_release(config);
+}
+
+/**
+ * @brief 从当前快照拷贝出一个配置段
+ */
+static void read_section(void* dst, size_t offset, size_t size) {
+    const system_config_t* config = config_manager_acquire(NULL);
+    memcpy(dst, (const uint8_t*)config + offset, size);
+    config_manager_release(config);
+}
+
+/**
+ * @brief 以新快照更新一个配置段，内容有变化时标记为脏并安排后台写入
+ */
+static void write_section(size_t offset, const void* src, size_t size, uint32_t section) {
+    xSemaphoreTake(g_config_mutex, portMAX_DELAY);
+    const uint8_t* current = (const uint8_t*)&atomic_load(&g_current_slot)->config;
+    bool changed = memcmp(current + offset, src, size) != 0;
+    if (changed) {
+        config_slot_t* slot = begin_update();
+        memcpy((uint8_t*)&slot->config + offset, src, size);
+        publish_update(slot);
+        g_dirty_sections |= section;
+    }
+    xSemaphoreGive(g_config_mutex);
     
-    return ESP_OK;
+    if (changed) {
+        schedule_flush();
+        notify_subscribers(section);
+    }
 }
 
-esp_err_t config_manager_init(void) {
-    esp_err_t ret = ESP_OK;
+/**
+ * @brief 后台写入任务
+ * @note 收到修改通知后等待CONFIG_FLUSH_DELAY_MS内不再有新修改再写文件，
+ *       把一次页面保存引起的多次修改合并为一次flash写入；持续修改时最多推迟CONFIG_FLUSH_MAX_DELAY_MS
+ */
+static void config_flush_task(void *pvParameters) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        
+        TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(CONFIG_FLUSH_MAX_DELAY_MS);
+        while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_FLUSH_DELAY_MS)) > 0 &&
+               (int32_t)(deadline - xTaskGetTickCount()) > 0) {
+        }
+        
+        config_manager_flush();
+    }
+}
+
+/**
+ * @brief 重启前写入未保存的修改
+ */
+static void config_shutdown_handler(void) {
+    config_manager_flush();
+}
+
+/**
+ * @brief 计算嵌入config.ini的CRC32，固件更新后内容变化则快照失效
+ */
+static uint32_t embedded_config_crc(void) {
+    return esp_rom_crc32_le(0, (const uint8_t*)config_ini_start, config_ini_end - config_ini_start);
+}
+
+/**
+ * @brief 挂载SPIFFS，已挂载时直接返回
+ * @return ESP_OK已挂载，其他值挂载失败
+ */
+static esp_err_t mount_spiffs(void) {
+    if (g_spiffs_mounted) {
+        return ESP_OK;
+    }
     
-    // 初始化SPIFFS
     esp_vfs_spiffs_conf_t conf = {
         .base_path = "/spiffs",
         .partition_label = NULL,
@@ -247,7 +586,7 @@ esp_err_t config_manager_init(void) {
         .format_if_mount_failed = true
     };
     
-    ret = esp_vfs_spiffs_register(&conf);
+    esp_err_t ret = esp_vfs_spiffs_register(&conf);
     if (ret != ESP_OK) {
         if (ret == ESP_FAIL) {
             ESP_LOGE(TAG, "Failed to mount or format filesystem");
@@ -258,54 +597,302 @@ esp_err_t config_manager_init(void) {
         }
         return ret;
     }
+    g_spiffs_mounted = true;
+    return ESP_OK;
+}
+
+/**
+ * @brief 读取覆盖层文件的大小和CRC32，用来判断快照生成后文件是否被替换
+ * @note 覆盖层文件只有几KB，按块读取计算CRC，不解析；没有文件时大小和CRC都为0
+ * @return ESP_OK成功，其他值读取失败
+ */
+static esp_err_t overlay_file_stamp(uint32_t* size, uint32_t* crc) {
+    *size = 0;
+    *crc = 0;
     
-    // 创建INI配置句柄
-    g_ini_config = ini_config_create();
-    if (!g_ini_config) {
-        ESP_LOGE(TAG, "Failed to create INI config");
-        return ESP_ERR_NO_MEM;
+    FILE* file = fopen(CONFIG_FILE_PATH, "rb");
+    if (!file) {
+        struct stat st;
+        return stat(CONFIG_FILE_PATH, &st) == 0 ? ESP_FAIL : ESP_OK;
+    }
+    
+    uint8_t buf[256];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), file)) > 0) {
+        *crc = esp_rom_crc32_le(*crc, buf, len);
+        *size += len;
+    }
+    esp_err_t ret = ferror(file) ? ESP_FAIL : ESP_OK;
+    fclose(file);
+    return ret;
+}
+
+/**
+ * @brief 计算快照除crc字段外的CRC32
+ */
+static uint32_t snapshot_crc(const config_snapshot_t* snapshot) {
+    return esp_rom_crc32_le(0, (const uint8_t*)snapshot, offsetof(config_snapshot_t, crc));
+}
+
+/**
+ * @brief 计算RTC缓存除crc字段外的CRC32
+ */
+static uint32_t rtc_cache_crc(void) {
+    return esp_rom_crc32_le(0, (const uint8_t*)&s_rtc_cache, offsetof(config_rtc_cache_t, crc));
+}
+
+/**
+ * @brief 从RTC缓存恢复配置
+ * @param generation 输出重启前的配置代数
+ * @return true缓存有效且已复制到config
+ */
+static bool load_rtc_cache(system_config_t* config, uint32_t* generation) {
+    // 上电和欠压复位后RTC内存内容不确定，只在软件重启、看门狗和异常复位后使用
+    esp_reset_reason_t reason = esp_reset_reason();
+    if (reason == ESP_RST_POWERON || reason == ESP_RST_BROWNOUT || reason == ESP_RST_UNKNOWN) {
+        return false;
     }
     
-    // 尝试从文件加载配置
-    ESP_LOGI(TAG, "Attempting to load config from: %s", CONFIG_FILE_PATH);
-    ret = ini_config_load_from_file(g_ini_config, CONFIG_FILE_PATH);
+    if (s_rtc_cache.magic != CONFIG_RTC_CACHE_MAGIC || s_rtc_cache.version != CONFIG_SNAPSHOT_VERSION ||
+        s_rtc_cache.size != sizeof(system_config_t) || s_rtc_cache.generation == 0 ||
+        s_rtc_cache.crc != rtc_cache_crc()) {
+        ESP_LOGI(TAG, "No valid config cache in RTC memory");
+        return false;
+    }
+    if (s_rtc_cache.embedded_crc != embedded_config_crc()) {
+        ESP_LOGI(TAG, "Embedded config.ini changed since RTC cache, ignoring");
+        return false;
+    }
+    
+    memcpy(config, &s_rtc_cache.config, sizeof(system_config_t));
+    *generation = s_rtc_cache.generation;
+    return true;
+}
+
+/**
+ * @brief 更新RTC缓存
+ */
+static void save_rtc_cache(const system_config_t* config, uint32_t generation) {
+    s_rtc_cache.magic = CONFIG_RTC_CACHE_MAGIC;
+    s_rtc_cache.version = CONFIG_SNAPSHOT_VERSION;
+    s_rtc_cache.size = sizeof(system_config_t);
+    s_rtc_cache.embedded_crc = embedded_config_crc();
+    s_rtc_cache.generation = generation;
+    memcpy(&s_rtc_cache.config, config, sizeof(system_config_t));
+    s_rtc_cache.crc = rtc_cache_crc();
+}
+
+/**
+ * @brief 从NVS读取配置快照
+ * @return true快照有效且已复制到config，false需要走SPIFFS和INI解析
+ * @note 需要挂载SPIFFS核对覆盖层文件，只读取文件计算CRC，不解析INI
+ */
+static bool load_snapshot(system_config_t* config) {
+    nvs_handle_t handle;
+    if (nvs_open(CONFIG_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    
+    config_snapshot_t* snapshot = malloc(sizeof(config_snapshot_t));
+    if (!snapshot) {
+        nvs_close(handle);
+        return false;
+    }
+    
+    size_t length = sizeof(config_snapshot_t);
+    esp_err_t ret = nvs_get_blob(handle, CONFIG_SNAPSHOT_KEY, snapshot, &length);
+    nvs_close(handle);
+    
+    bool valid = false;
     if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to load config file from SPIFFS (error: %s), copying embedded config", esp_err_to_name(ret));
-        // 复制嵌入的配置文件到SPIFFS
-        ret = copy_embedded_config_to_spiffs();
-        if (ret == ESP_OK) {
-            // 重新尝试加载配置文件
-            ret = ini_config_load_from_file(g_ini_config, CONFIG_FILE_PATH);
-            if (ret == ESP_OK) {
-                ESP_LOGI(TAG, "Config file loaded from embedded copy");
-                load_from_ini(&g_system_config);
-            } else {
-                ESP_LOGE(TAG, "Failed to load config even after copying embedded file, using defaults");
-                load_default_config(&g_system_config);
-                save_to_ini(&g_system_config);
-                ini_config_save_to_file(g_ini_config, CONFIG_FILE_PATH);
-            }
+        ESP_LOGI(TAG, "No config snapshot in NVS (%s)", esp_err_to_name(ret));
+    } else if (length != sizeof(config_snapshot_t) || snapshot->magic != CONFIG_SNAPSHOT_MAGIC ||
+               snapshot->version != CONFIG_SNAPSHOT_VERSION || snapshot->size != sizeof(system_config_t)) {
+        ESP_LOGW(TAG, "Config snapshot has an incompatible layout, ignoring");
+    } else if (snapshot->crc != snapshot_crc(snapshot)) {
+        ESP_LOGW(TAG, "Config snapshot checksum mismatch, ignoring");
+    } else if (snapshot->embedded_crc != embedded_config_crc()) {
+        ESP_LOGI(TAG, "Embedded config.ini changed since snapshot, re-importing");
+    } else if (mount_spiffs() == ESP_OK) {
+        struct stat st;
+        uint32_t overlay_size;
+        uint32_t overlay_crc;
+        if (stat(CONFIG_FILE_PATH INI_SAVE_TMP_SUFFIX, &st) == 0) {
+            // 上次保存被打断，走INI路径从临时文件恢复
+            ESP_LOGI(TAG, "Interrupted config save found, re-importing");
+        } else if (overlay_file_stamp(&overlay_size, &overlay_crc) != ESP_OK ||
+                   overlay_size != snapshot->overlay_size || overlay_crc != snapshot->overlay_crc) {
+            ESP_LOGI(TAG, "%s changed since snapshot, re-importing", CONFIG_FILE_PATH);
         } else {
-            ESP_LOGE(TAG, "Failed to copy embedded config, using defaults");
-            load_default_config(&g_system_config);
-            save_to_ini(&g_system_config);
-            ini_config_save_to_file(g_ini_config, CONFIG_FILE_PATH);
+            memcpy(config, &snapshot->config, sizeof(system_config_t));
+            valid = true;
+        }
+    }
+    
+    free(snapshot);
+    return valid;
+}
+
+/**
+ * @brief 将配置快照写入NVS和RTC缓存，在INI文件成功写入后调用
+ * @param generation 快照对应的配置代数
+ * @note 同时记录覆盖层文件的大小和CRC32，读取文件失败时不写NVS快照
+ */
+static void save_snapshot(const system_config_t* config, uint32_t generation) {
+    save_rtc_cache(config, generation);
+    
+    config_snapshot_t* snapshot = calloc(1, sizeof(config_snapshot_t));
+    if (!snapshot) {
+        ESP_LOGW(TAG, "Failed to allocate config snapshot");
+        return;
+    }
+    if (overlay_file_stamp(&snapshot->overlay_size, &snapshot->overlay_crc) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to read %s, not writing config snapshot", CONFIG_FILE_PATH);
+        free(snapshot);
+        return;
+    }
+    
+    snapshot->magic = CONFIG_SNAPSHOT_MAGIC;
+    snapshot->version = CONFIG_SNAPSHOT_VERSION;
+    snapshot->size = sizeof(system_config_t);
+    snapshot->embedded_crc = embedded_config_crc();
+    memcpy(&snapshot->config, config, sizeof(system_config_t));
+    snapshot->crc = snapshot_crc(snapshot);
+    
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(CONFIG_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(handle, CONFIG_SNAPSHOT_KEY, snapshot, sizeof(config_snapshot_t));
+        if (ret == ESP_OK) {
+            ret = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    free(snapshot);
+    
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to write config snapshot: %s", esp_err_to_name(ret));
+    }
+}
+
+/**
+ * @brief 删除NVS中的配置快照和RTC缓存
+ * @note 写INI文件前调用，写文件过程中断电时下次启动不会用到与文件不一致的旧快照
+ */
+static void invalidate_snapshot(void) {
+    s_rtc_cache.magic = 0;
+    
+    nvs_handle_t handle;
+    if (nvs_open(CONFIG_NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+        if (nvs_erase_key(handle, CONFIG_SNAPSHOT_KEY) == ESP_OK) {
+            nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+}
+
+/**
+ * @brief 加载基础层和覆盖层
+ * @note 基础层就地解析嵌入flash的config.ini，覆盖层需要挂载SPIFFS；使用快照启动时推迟到第一次写入配置时调用
+ * @return ESP_OK已加载，其他值SPIFFS挂载失败
+ */
+static esp_err_t load_ini_config(void) {
+    size_t config_size = config_ini_end - config_ini_start;
+    if (ini_config_load_from_rodata(g_base_ini, config_ini_start, config_size) != ESP_OK) {
+        // 基础层不可用时未覆盖的项使用字段表默认值
+        ESP_LOGE(TAG, "Failed to parse embedded config.ini, using built-in defaults as base");
+        ini_config_clear(g_base_ini);
+    }
+    
+    // 初始化SPIFFS，核对快照时可能已挂载
+    esp_err_t ret = mount_spiffs();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    // 用户修改过配置时SPIFFS中才会有覆盖层文件
+    if (load_from_spiffs() != ESP_OK) {
+        ini_config_clear(g_overlay_ini);
+        ESP_LOGI(TAG, "No user overrides, using embedded config.ini (%d bytes)", (int)config_size);
+        return ESP_OK;
+    }
+    
+    int pruned = prune_overlay();
+    if (pruned > 0) {
+        ESP_LOGI(TAG, "Dropped %d keys equal to embedded config.ini from %s", pruned, CONFIG_FILE_PATH);
+        write_config_file();
+    }
+    ESP_LOGI(TAG, "Loaded %d user overrides from %s", ini_config_get_item_count(g_overlay_ini), CONFIG_FILE_PATH);
+    return ESP_OK;
+}
+
+esp_err_t config_manager_init(void) {
+    int64_t start_us = esp_timer_get_time();
+    
+    g_config_mutex = xSemaphoreCreateMutex();
+    g_flush_mutex = xSemaphoreCreateMutex();
+    if (!g_config_mutex || !g_flush_mutex) {
+        ESP_LOGE(TAG, "Failed to create config mutex");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // 创建两层INI配置句柄（字符串arena放在PSRAM，为WiFi/lwIP留出内部RAM）
+    g_base_ini = ini_config_create_with_flags(INI_CONFIG_FLAG_PSRAM);
+    g_overlay_ini = ini_config_create_with_flags(INI_CONFIG_FLAG_PSRAM);
+    if (!g_base_ini || !g_overlay_ini) {
+        ESP_LOGE(TAG, "Failed to create INI config");
+        return ESP_ERR_NO_MEM;
+    }
+    ini_config_declare(g_base_ini, s_value_specs, sizeof(s_value_specs) / sizeof(s_value_specs[0]));
+    ini_config_declare(g_overlay_ini, s_value_specs, sizeof(s_value_specs) / sizeof(s_value_specs[0]));
+    
+    // 软件重启后优先使用RTC缓存，跳过SPIFFS挂载和INI解析；其次NVS中的二进制快照，
+    // 核对覆盖层文件未变后跳过INI解析
+    config_slot_t* slot = begin_update();
+    system_config_t* initial = &slot->config;
+    const char* source;
+    if (load_rtc_cache(initial, &g_generation)) {
+        // 发布时代数加1，恢复为重启前的代数
+        g_generation--;
+        source = "RTC cache";
+    } else if (load_snapshot(initial)) {
+        source = "NVS snapshot";
+    } else {
+        esp_err_t ret = load_ini_config();
+        if (ret != ESP_OK) {
+            return ret;
         }
+        // 从两层INI配置加载到系统配置结构体
+        load_from_ini(initial);
+        g_ini_loaded = true;
+        source = "SPIFFS/INI";
+    }
+    publish_update(slot);
+    
+    if (g_ini_loaded) {
+        save_snapshot(initial, slot->generation);
     } else {
-        ESP_LOGI(TAG, "Config file loaded successfully from SPIFFS");
-        // 从INI文件加载配置到系统配置结构体
-        load_from_ini(&g_system_config);
+        save_rtc_cache(initial, slot->generation);
     }
     
     // 调试：打印加载的MQTT配置
     ESP_LOGI(TAG, "Loaded MQTT config - broker_host: '%s', broker_port: %d", 
-             g_system_config.mqtt.broker_host, g_system_config.mqtt.broker_port);
+             initial->mqtt.broker_host, initial->mqtt.broker_port);
     
-    // 调试：打印加载的认证配置
-    ESP_LOGI(TAG, "Loaded auth config - Username: '%s', Password hash: '%s'", 
-             g_system_config.auth.username, g_system_config.auth.password_hash);
+    // 调试：打印加载的认证配置，不输出密码哈希
+    ESP_LOGI(TAG, "Loaded auth config - Username: '%s', PBKDF2 iterations: %d", 
+             initial->auth.username, initial->auth.pbkdf2_iterations);
     
     g_config_loaded = true;
+    
+    // 修改由后台任务合并后写入，重启时通过关机回调写入尚未落盘的修改
+    if (xTaskCreate(config_flush_task, "config_flush", 4096, NULL, 2, &g_flush_task_handle) != pdPASS) {
+        ESP_LOGW(TAG, "Failed to create config flush task, changes are written on flush only");
+    }
+    esp_register_shutdown_handler(config_shutdown_handler);
+    
+    ESP_LOGI(TAG, "Configuration ready in %lld us (%s, generation %" PRIu32 ")",
+             esp_timer_get_time() - start_us, source, slot->generation);
     ESP_LOGI(TAG, "Configuration manager initialized successfully");
     return ESP_OK;
 }
@@ -320,10 +907,99 @@ esp_err_t config_manager_load(system_config_t* config) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    memcpy(config, &g_system_config, sizeof(system_config_t));
+    read_section(config, 0, sizeof(system_config_t));
+    return ESP_OK;
+}
+
+const system_config_t* config_manager_acquire(uint32_t* generation) {
+    if (!g_config_loaded) {
+        return NULL;
+    }
+    
+    // 增加引用计数后再确认槽位仍是当前快照，否则写者可能已在复用它
+    config_slot_t* slot;
+    while (1) {
+        slot = atomic_load(&g_current_slot);
+        atomic_fetch_add(&slot->refs, 1);
+        if (slot == atomic_load(&g_current_slot)) {
+            break;
+        }
+        atomic_fetch_sub(&slot->refs, 1);
+    }
+    
+    if (generation) {
+        *generation = slot->generation;
+    }
+    return &slot->config;
+}
+
+void config_manager_release(const system_config_t* config) {
+    if (config) {
+        // config是槽位的第一个成员
+        config_slot_t* slot = (config_slot_t*)config;
+        atomic_fetch_sub(&slot->refs, 1);
+    }
+}
+
+uint32_t config_manager_get_generation(void) {
+    config_slot_t* slot = atomic_load(&g_current_slot);
+    return slot ? slot->generation : 0;
+}
+
+esp_err_t config_manager_subscribe(uint32_t sections, config_change_cb_t cb, void* arg) {
+    if (!cb || !(sections & CONFIG_SECTION_ALL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (!g_config_loaded) {
+        ESP_LOGE(TAG, "Configuration not loaded");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    int index = -1;
+    xSemaphoreTake(g_config_mutex, portMAX_DELAY);
+    for (int i = 0; i < CONFIG_MAX_SUBSCRIBERS; i++) {
+        if (!g_subscribers[i].cb) {
+            g_subscribers[i].sections = sections;
+            g_subscribers[i].cb = cb;
+            g_subscribers[i].arg = arg;
+            index = i;
+            break;
+        }
+    }
+    xSemaphoreGive(g_config_mutex);
+    
+    if (index < 0) {
+        ESP_LOGE(TAG, "Too many config subscribers (max %d)", CONFIG_MAX_SUBSCRIBERS);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // 以当前配置调用一次，订阅者由此得到初始值
+    const system_config_t* config = config_manager_acquire(NULL);
+    cb(sections & CONFIG_SECTION_ALL, config, arg);
+    config_manager_release(config);
     return ESP_OK;
 }
 
+esp_err_t config_manager_unsubscribe(config_change_cb_t cb, void* arg) {
+    if (!g_config_loaded) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    
+    xSemaphoreTake(g_config_mutex, portMAX_DELAY);
+    for (int i = 0; i < CONFIG_MAX_SUBSCRIBERS; i++) {
+        if (g_subscribers[i].cb == cb && g_subscribers[i].arg == arg) {
+            memset(&g_subscribers[i], 0, sizeof(config_subscriber_t));
+            ret = ESP_OK;
+            break;
+        }
+    }
+    xSemaphoreGive(g_config_mutex);
+    return ret;
+}
+
 esp_err_t config_manager_save(const system_config_t* config) {
     if (!config) {
         return ESP_ERR_INVALID_ARG;
@@ -334,24 +1010,78 @@ esp_err_t config_manager_save(const system_config_t* config) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    // 更新内存中的配置
-    memcpy(&g_system_config, config, sizeof(system_config_t));
+    // 只标记内容有变化的配置段，文件由后台任务合并写入
+    uint32_t changed = 0;
+    xSemaphoreTake(g_config_mutex, portMAX_DELAY);
+    const system_config_t* current = &atomic_load(&g_current_slot)->config;
+    for (size_t i = 0; i < sizeof(s_section_layout) / sizeof(s_section_layout[0]); i++) {
+        const uint8_t* src = (const uint8_t*)config + s_section_layout[i].offset;
+        const uint8_t* dst = (const uint8_t*)current + s_section_layout[i].offset;
+        if (memcmp(dst, src, s_section_layout[i].size) != 0) {
+            changed |= s_section_layout[i].section;
+        }
+    }
+    if (changed) {
+        config_slot_t* slot = begin_update();
+        memcpy(&slot->config, config, sizeof(system_config_t));
+        publish_update(slot);
+    }
+    g_dirty_sections |= changed;
+    xSemaphoreGive(g_config_mutex);
     
-    // 保存到INI配置并写入文件
-    esp_err_t ret = save_to_ini(config);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to save to INI config");
-        return ret;
+    if (changed) {
+        schedule_flush();
+        notify_subscribers(changed);
+    }
+    return ESP_OK;
+}
+
+esp_err_t config_manager_flush(void) {
+    if (!g_config_loaded) {
+        return ESP_ERR_INVALID_STATE;
     }
     
-    ret = ini_config_save_to_file(g_ini_config, CONFIG_FILE_PATH);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to save config file");
-        return ret;
+    xSemaphoreTake(g_flush_mutex, portMAX_DELAY);
+    
+    // 取出脏标记和配置快照后立即释放配置锁，写文件期间不阻塞读写配置
+    xSemaphoreTake(g_config_mutex, portMAX_DELAY);
+    config_slot_t* current = atomic_load(&g_current_slot);
+    uint32_t dirty = g_dirty_sections;
+    uint32_t generation = current->generation;
+    g_dirty_sections = 0;
+    memcpy(&g_flush_snapshot, &current->config, sizeof(system_config_t));
+    xSemaphoreGive(g_config_mutex);
+    
+    esp_err_t ret = ESP_OK;
+    if (dirty) {
+        if (!g_ini_loaded) {
+            // 由快照启动时INI还未加载，第一次写入前挂载SPIFFS并加载，保留覆盖层中的其他键
+            ret = load_ini_config();
+            g_ini_loaded = ret == ESP_OK;
+        }
+        
+        if (ret == ESP_OK) {
+            invalidate_snapshot();
+            ret = save_to_ini(&g_flush_snapshot, dirty);
+        }
+        if (ret == ESP_OK) {
+            ret = write_config_file();
+        }
+        
+        if (ret == ESP_OK) {
+            save_snapshot(&g_flush_snapshot, generation);
+            ESP_LOGI(TAG, "Configuration saved successfully (sections 0x%03" PRIx32 ")", dirty);
+        } else {
+            // 写入失败时恢复脏标记，下次修改或flush时重试
+            ESP_LOGE(TAG, "Failed to save config file: %s", esp_err_to_name(ret));
+            xSemaphoreTake(g_config_mutex, portMAX_DELAY);
+            g_dirty_sections |= dirty;
+            xSemaphoreGive(g_config_mutex);
+        }
     }
     
-    ESP_LOGI(TAG, "Configuration saved successfully");
-    return ESP_OK;
+    xSemaphoreGive(g_flush_mutex);
+    return ret;
 }
 
 esp_err_t config_manager_get_wifi_ap(xj1_wifi_ap_config_t* config) {
@@ -359,7 +1089,7 @@ esp_err_t config_manager_get_wifi_ap(xj1_wifi_ap_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(config, &g_system_config.wifi_ap, sizeof(xj1_wifi_ap_config_t));
+    read_section(config, offsetof(system_config_t, wifi_ap), sizeof(xj1_wifi_ap_config_t));
     return ESP_OK;
 }
 
@@ -368,8 +1098,8 @@ esp_err_t config_manager_set_wifi_ap(const xj1_wifi_ap_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(&g_system_config.wifi_ap, config, sizeof(xj1_wifi_ap_config_t));
-    return config_manager_save(&g_system_config);
+    write_section(offsetof(system_config_t, wifi_ap), config, sizeof(xj1_wifi_ap_config_t), CONFIG_SECTION_WIFI_AP);
+    return ESP_OK;
 }
 
 esp_err_t config_manager_get_wifi_sta(xj1_wifi_sta_config_t* config) {
@@ -377,7 +1107,7 @@ esp_err_t config_manager_get_wifi_sta(xj1_wifi_sta_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(config, &g_system_config.wifi_sta, sizeof(xj1_wifi_sta_config_t));
+    read_section(config, offsetof(system_config_t, wifi_sta), sizeof(xj1_wifi_sta_config_t));
     return ESP_OK;
 }
 
@@ -386,8 +1116,8 @@ esp_err_t config_manager_set_wifi_sta(const xj1_wifi_sta_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(&g_system_config.wifi_sta, config, sizeof(xj1_wifi_sta_config_t));
-    return config_manager_save(&g_system_config);
+    write_section(offsetof(system_config_t, wifi_sta), config, sizeof(xj1_wifi_sta_config_t), CONFIG_SECTION_WIFI_STA);
+    return ESP_OK;
 }
 
 esp_err_t config_manager_get_ethernet(ethernet_config_t* config) {
@@ -395,7 +1125,7 @@ esp_err_t config_manager_get_ethernet(ethernet_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(config, &g_system_config.ethernet, sizeof(ethernet_config_t));
+    read_section(config, offsetof(system_config_t, ethernet), sizeof(ethernet_config_t));
     return ESP_OK;
 }
 
@@ -404,8 +1134,8 @@ esp_err_t config_manager_set_ethernet(const ethernet_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(&g_system_config.ethernet, config, sizeof(ethernet_config_t));
-    return config_manager_save(&g_system_config);
+    write_section(offsetof(system_config_t, ethernet), config, sizeof(ethernet_config_t), CONFIG_SECTION_ETHERNET);
+    return ESP_OK;
 }
 
 esp_err_t config_manager_get_auth(auth_config_t* config) {
@@ -413,7 +1143,7 @@ esp_err_t config_manager_get_auth(auth_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(config, &g_system_config.auth, sizeof(auth_config_t));
+    read_section(config, offsetof(system_config_t, auth), sizeof(auth_config_t));
     return ESP_OK;
 }
 
@@ -422,8 +1152,8 @@ esp_err_t config_manager_set_auth(const auth_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(&g_system_config.auth, config, sizeof(auth_config_t));
-    return config_manager_save(&g_system_config);
+    write_section(offsetof(system_config_t, auth), config, sizeof(auth_config_t), CONFIG_SECTION_AUTH);
+    return ESP_OK;
 }
 
 esp_err_t config_manager_get_bluetooth(bluetooth_config_t* config) {
@@ -431,7 +1161,7 @@ esp_err_t config_manager_get_bluetooth(bluetooth_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(config, &g_system_config.bluetooth, sizeof(bluetooth_config_t));
+    read_section(config, offsetof(system_config_t, bluetooth), sizeof(bluetooth_config_t));
     return ESP_OK;
 }
 
@@ -440,8 +1170,8 @@ esp_err_t config_manager_set_bluetooth(const bluetooth_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(&g_system_config.bluetooth, config, sizeof(bluetooth_config_t));
-    return config_manager_save(&g_system_config);
+    write_section(offsetof(system_config_t, bluetooth), config, sizeof(bluetooth_config_t), CONFIG_SECTION_BLUETOOTH);
+    return ESP_OK;
 }
 
 esp_err_t config_manager_get_mqtt(mqtt_config_t* config) {
@@ -449,7 +1179,7 @@ esp_err_t config_manager_get_mqtt(mqtt_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(config, &g_system_config.mqtt, sizeof(mqtt_config_t));
+    read_section(config, offsetof(system_config_t, mqtt), sizeof(mqtt_config_t));
     return ESP_OK;
 }
 
@@ -458,8 +1188,8 @@ esp_err_t config_manager_set_mqtt(const mqtt_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(&g_system_config.mqtt, config, sizeof(mqtt_config_t));
-    return config_manager_save(&g_system_config);
+    write_section(offsetof(system_config_t, mqtt), config, sizeof(mqtt_config_t), CONFIG_SECTION_MQTT);
+    return ESP_OK;
 }
 
 esp_err_t config_manager_get_web_server(web_server_config_t* config) {
@@ -467,7 +1197,7 @@ esp_err_t config_manager_get_web_server(web_server_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(config, &g_system_config.web_server, sizeof(web_server_config_t));
+    read_section(config, offsetof(system_config_t, web_server), sizeof(web_server_config_t));
     return ESP_OK;
 }
 
@@ -476,8 +1206,8 @@ esp_err_t config_manager_set_web_server(const web_server_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(&g_system_config.web_server, config, sizeof(web_server_config_t));
-    return config_manager_save(&g_system_config);
+    write_section(offsetof(system_config_t, web_server), config, sizeof(web_server_config_t), CONFIG_SECTION_WEB_SERVER);
+    return ESP_OK;
 }
 
 esp_err_t config_manager_reset_to_default(void) {
@@ -485,20 +1215,40 @@ esp_err_t config_manager_reset_to_default(void) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    // 加载默认配置
-    load_default_config(&g_system_config);
+    xSemaphoreTake(g_flush_mutex, portMAX_DELAY);
     
-    // 保存到文件
-    esp_err_t ret = save_to_ini(&g_system_config);
-    if (ret != ESP_OK) {
-        return ret;
+    esp_err_t ret = ESP_OK;
+    if (!g_ini_loaded) {
+        ret = load_ini_config();
+        g_ini_loaded = ret == ESP_OK;
+    }
+    
+    if (ret == ESP_OK) {
+        // 恢复默认即回到基础层：发布基础层配置并删除覆盖层，不再重写整份配置
+        xSemaphoreTake(g_config_mutex, portMAX_DELAY);
+        config_slot_t* slot = begin_update();
+        load_base_config(&slot->config);
+        publish_update(slot);
+        g_dirty_sections = 0;
+        memcpy(&g_flush_snapshot, &slot->config, sizeof(system_config_t));
+        xSemaphoreGive(g_config_mutex);
+        
+        ini_config_clear(g_overlay_ini);
+        invalidate_snapshot();
+        ret = write_config_file();
+        if (ret == ESP_OK) {
+            save_snapshot(&g_flush_snapshot, slot->generation);
+        }
     }
     
-    ret = ini_config_save_to_file(g_ini_config, CONFIG_FILE_PATH);
+    xSemaphoreGive(g_flush_mutex);
+    
     if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to reset configuration: %s", esp_err_to_name(ret));
         return ret;
     }
     
+    notify_subscribers(CONFIG_SECTION_ALL);
     ESP_LOGI(TAG, "Configuration reset to default values");
     return ESP_OK;
 }
@@ -508,7 +1258,7 @@ esp_err_t config_manager_get_timeouts(timeout_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(config, &g_system_config.timeouts, sizeof(timeout_config_t));
+    read_section(config, offsetof(system_config_t, timeouts), sizeof(timeout_config_t));
     return ESP_OK;
 }
 
@@ -517,6 +1267,111 @@ esp_err_t config_manager_get_intervals(interval_config_t* config) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(config, &g_system_config.intervals, sizeof(interval_config_t));
+    read_section(config, offsetof(system_config_t, intervals), sizeof(interval_config_t));
+    return ESP_OK;
+}
+
+esp_err_t config_manager_to_json(const system_config_t* config, cJSON* json) {
+    if (!config || !json) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // 同一段的字段在表中连续排列，按段创建子对象
+    cJSON* section = NULL;
+    const char* section_name = NULL;
+    
+    for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+        const config_field_t* field = &s_config_fields[i];
+        if (field->flags & CONFIG_FIELD_PRIVATE) {
+            continue;
+        }
+        
+        if (!section_name || strcmp(field->section, section_name) != 0) {
+            section_name = field->section;
+            section = cJSON_AddObjectToObject(json, section_name);
+            if (!section) {
+                return ESP_ERR_NO_MEM;
+            }
+        }
+        
+        cJSON* item;
+        if (field->type == CONFIG_FIELD_STRING) {
+            item = cJSON_AddStringToObject(section, field->key, field_cptr(config, field));
+        } else {
+            item = cJSON_AddNumberToObject(section, field->key, *(const int*)field_cptr(config, field));
+        }
+        if (!item) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief 按段名和键名查找配置字段
+ * @param key 为NULL时只查找段
+ */
+static const config_field_t* find_field(const char* section, const char* key) {
+    for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+        const config_field_t* field = &s_config_fields[i];
+        if (strcmp(field->section, section) == 0 && (!key || strcmp(field->key, key) == 0)) {
+            return field;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t config_manager_from_json(const cJSON* json, system_config_t* config, uint32_t* sections,
+                                   char* error, size_t error_size) {
+    if (!json || !config || !cJSON_IsObject(json)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    uint32_t touched = 0;
+    const cJSON* section;
+    cJSON_ArrayForEach(section, json) {
+        const config_field_t* first = find_field(section->string, NULL);
+        if (!first) {
+            snprintf(error, error_size, "未知的配置段: %s", section->string);
+            return ESP_ERR_NOT_FOUND;
+        }
+        if (!cJSON_IsObject(section)) {
+            snprintf(error, error_size, "配置段%s必须是对象", section->string);
+            return ESP_ERR_INVALID_ARG;
+        }
+        
+        const cJSON* item;
+        cJSON_ArrayForEach(item, section) {
+            const config_field_t* field = find_field(section->string, item->string);
+            if (!field || (field->flags & CONFIG_FIELD_PRIVATE)) {
+                snprintf(error, error_size, "未知或不可修改的配置项: %s.%s", section->string, item->string);
+                return ESP_ERR_NOT_FOUND;
+            }
+            
+            // 超长的字符串和超出范围的整数直接拒绝，不截断或替换为默认值
+            if (field->type == CONFIG_FIELD_STRING) {
+                if (!cJSON_IsString(item) || strlen(item->valuestring) >= field->size) {
+                    snprintf(error, error_size, "%s.%s必须是长度小于%u的字符串",
+                             field->section, field->key, (unsigned)field->size);
+                    return ESP_ERR_INVALID_ARG;
+                }
+                strcpy(field_ptr(config, field), item->valuestring);
+            } else {
+                double value = item->valuedouble;
+                if (!cJSON_IsNumber(item) || value < field->min || value > field->max || value != (int)value) {
+                    snprintf(error, error_size, "%s.%s必须是%d到%d之间的整数",
+                             field->section, field->key, field->min, field->max);
+                    return ESP_ERR_INVALID_ARG;
+                }
+                *(int*)field_ptr(config, field) = (int)value;
+            }
+            touched |= field->section_flag;
+        }
+    }
+    
+    if (sections) {
+        *sections = touched;
+    }
     return ESP_OK;
 }
@@ -22,12 +22,33 @@
 
 #include "esp_err.h"
 #include "ini_parser.h"
+#include "cJSON.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define CONFIG_FILE_PATH "/spiffs/config.ini"
+#define CONFIG_FILE_PATH "/spiffs/config.ini"  // 用户覆盖层，只保存与嵌入config.ini不同的键
+#define CONFIG_FLUSH_DELAY_MS 2000       // 修改后等待合并的时间窗口，窗口内的修改只写一次文件
+#define CONFIG_FLUSH_MAX_DELAY_MS 10000  // 持续修改时最长推迟写入的时间
+#define CONFIG_SNAPSHOT_SLOTS 4          // 配置快照槽位数，可同时被读者持有的旧快照数为该值减1
+#define CONFIG_MAX_SUBSCRIBERS 8         // 配置变化订阅者的最大数量
+
+/**
+ * @brief 配置段标志，用于标记需要写入文件的配置段
+ */
+typedef enum {
+    CONFIG_SECTION_WIFI_AP    = 1 << 0,
+    CONFIG_SECTION_WIFI_STA   = 1 << 1,
+    CONFIG_SECTION_ETHERNET   = 1 << 2,
+    CONFIG_SECTION_AUTH       = 1 << 3,
+    CONFIG_SECTION_BLUETOOTH  = 1 << 4,
+    CONFIG_SECTION_MQTT       = 1 << 5,
+    CONFIG_SECTION_WEB_SERVER = 1 << 6,
+    CONFIG_SECTION_TIMEOUTS   = 1 << 7,
+    CONFIG_SECTION_INTERVALS  = 1 << 8,
+    CONFIG_SECTION_ALL        = (1 << 9) - 1,
+} config_section_t;
 
 /**
  * @brief WiFi AP配置结构体
@@ -61,7 +82,8 @@ typedef struct {
  */
 typedef struct {
     char username[32];
-    char password_hash[65];  // SHA-256哈希值(64字符) + '\0'
+    char password_hash[128]; // pbkdf2-sha256$迭代次数$盐$哈希，旧版为64字符的SHA-256哈希值
+    int pbkdf2_iterations;   // 新密码哈希的PBKDF2迭代次数
 } auth_config_t;
 
 /**
@@ -92,6 +114,9 @@ typedef struct {
  */
 typedef struct {
     int port;
+    int max_sessions;        // 最大并发会话数，重启后生效
+    int stateless_sessions;  // 1: 登录签发无状态令牌，重启后生效
+    int persist_sessions;    // 1: 重启后恢复会话，重启后生效
 } web_server_config_t;
 
 /**
@@ -143,13 +168,73 @@ esp_err_t config_manager_init(void);
  */
 esp_err_t config_manager_load(system_config_t* config);
 
+/**
+ * @brief 获取当前配置快照的只读指针，不加锁也不复制
+ * @param generation 输出快照代数，每次配置变化加1，可为NULL
+ * @return 配置快照指针，未初始化时返回NULL
+ * @note 快照发布后内容不再改变，读者看到的总是一份完整的配置；
+ *       用完必须调用config_manager_release，持有期间配置更新会使用其他槽位，
+ *       不要长时间持有（如跨越vTaskDelay）
+ */
+const system_config_t* config_manager_acquire(uint32_t* generation);
+
+/**
+ * @brief 释放config_manager_acquire获取的快照
+ * @param config 配置快照指针
+ */
+void config_manager_release(const system_config_t* config);
+
+/**
+ * @brief 获取当前配置的代数，用于低成本判断配置是否变化
+ * @return 代数，未初始化时为0
+ * @note 软件重启后从RTC缓存恢复时代数延续重启前的值
+ */
+uint32_t config_manager_get_generation(void);
+
+/**
+ * @brief 配置变化回调
+ * @param sections 发生变化且已订阅的配置段(config_section_t)
+ * @param config 变化后的配置快照，只在回调期间有效
+ * @param arg 订阅时传入的参数
+ * @note 在修改配置的任务中执行（通常是Web服务器任务），应只缓存需要的值或通知自己的任务，不要阻塞
+ */
+typedef void (*config_change_cb_t)(uint32_t sections, const system_config_t* config, void* arg);
+
+/**
+ * @brief 订阅配置段的变化
+ * @param sections 关心的配置段(config_section_t)，可按位组合
+ * @param cb 回调函数
+ * @param arg 传给回调的参数
+ * @return ESP_OK成功，ESP_ERR_NO_MEM订阅者已满，其他值失败
+ * @note 订阅成功后立即以当前配置调用一次回调，订阅者不需要再单独读取初始值
+ */
+esp_err_t config_manager_subscribe(uint32_t sections, config_change_cb_t cb, void* arg);
+
+/**
+ * @brief 取消订阅
+ * @param cb 订阅时的回调函数
+ * @param arg 订阅时的参数
+ * @return ESP_OK成功，ESP_ERR_NOT_FOUND未订阅
+ * @note 返回时正在进行的通知仍可能再调用一次回调
+ */
+esp_err_t config_manager_unsubscribe(config_change_cb_t cb, void* arg);
+
 /**
  * @brief 保存系统配置
  * @param config 系统配置结构体指针
  * @return ESP_OK成功，其他值失败
+ * @note 只更新内存并标记有变化的配置段，文件在CONFIG_FLUSH_DELAY_MS内没有新修改后由后台任务写入，
+ *       set_*接口相同
  */
 esp_err_t config_manager_save(const system_config_t* config);
 
+/**
+ * @brief 立即将尚未写入的配置修改写入文件
+ * @return ESP_OK成功或没有需要写入的修改，其他值失败
+ * @note 已注册为关机回调，esp_restart()前会自动调用
+ */
+esp_err_t config_manager_flush(void);
+
 /**
  * @brief 获取WiFi AP配置
  * @param config WiFi AP配置结构体指针
@@ -164,6 +249,13 @@ esp_err_t config_manager_get_wifi_ap(xj1_wifi_ap_config_t* config);
  */
 esp_err_t config_manager_get_web_server(web_server_config_t* config);
 
+/**
+ * @brief 设置Web服务器配置
+ * @param config Web服务器配置结构体指针
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t config_manager_set_web_server(const web_server_config_t* config);
+
 /**
  * @brief 设置WiFi AP配置
  * @param config WiFi AP配置结构体指针
@@ -244,6 +336,7 @@ esp_err_t config_manager_set_mqtt(const mqtt_config_t* config);
 /**
  * @brief 重置配置为默认值
  * @return ESP_OK成功，其他值失败
+ * @note 默认值即嵌入固件的config.ini，重置只删除用户覆盖层文件
  */
 esp_err_t config_manager_reset_to_default(void);
 
@@ -261,6 +354,28 @@ esp_err_t config_manager_get_timeouts(timeout_config_t* config);
  */
 esp_err_t config_manager_get_intervals(interval_config_t* config);
 
+/**
+ * @brief 将配置导出为JSON，每个配置段一个子对象
+ * @param config 系统配置结构体指针
+ * @param json 输出的JSON对象，配置段作为其成员添加
+ * @return ESP_OK成功，其他值失败
+ * @note 认证信息不导出
+ */
+esp_err_t config_manager_to_json(const system_config_t* config, cJSON* json);
+
+/**
+ * @brief 将JSON中的配置项合并到配置结构体，格式与config_manager_to_json相同
+ * @param json 以配置段为成员的JSON对象，可以只包含部分配置段和部分字段
+ * @param config 输入输出的系统配置结构体指针，通常先复制当前配置
+ * @param sections 输出JSON中出现的配置段(config_section_t)，可为NULL
+ * @param error 输出错误描述，为NULL时error_size应为0
+ * @param error_size 错误描述缓冲区大小
+ * @return ESP_OK成功，ESP_ERR_NOT_FOUND未知或不可修改的段和字段，ESP_ERR_INVALID_ARG类型错误、字符串过长或超出范围
+ * @note 失败时config可能已被部分修改，调用者应丢弃它，不要保存
+ */
+esp_err_t config_manager_from_json(const cJSON* json, system_config_t* config, uint32_t* sections,
+                                   char* error, size_t error_size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+"""
+构建时压缩网页：每个输入文件压缩为<输出目录>/<文件名>.gz，并生成web_assets.h，
+记录压缩后内容的SHA-256前16个十六进制字符作为HTTP强ETag
+
+用法: embed_web_assets.py <输出目录> <网页文件>...
+
+压缩结果不含文件名和时间戳，内容不变时ETag不变
+"""
+
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit('usage: embed_web_assets.py <output_dir> <file>...')
+
+    output_dir = sys.argv[1]
+    lines = ['// 由embed_web_assets.py生成，不要手动修改', '#pragma once', '']
+    for path in sys.argv[2:]:
+        with open(path, 'rb') as f:
+            data = f.read()
+        name = os.path.basename(path)
+        compressed = gzip.compress(data, compresslevel=9, mtime=0)
+        with open(os.path.join(output_dir, name + '.gz'), 'wb') as f:
+            f.write(compressed)
+
+        macro = re.sub(r'[^A-Z0-9]', '_', name.upper())
+        etag = hashlib.sha256(compressed).hexdigest()[:16]
+        lines.append('#define WEB_ASSET_%s_ETAG "\\"%s\\""  // %d -> %d bytes' %
+                     (macro, etag, len(data), len(compressed)))
+
+    header = '\n'.join(lines) + '\n'
+    header_path = os.path.join(output_dir, 'web_assets.h')
+    # 内容相同时不重写，避免web_server.c无谓重新编译
+    if not os.path.exists(header_path) or open(header_path).read() != header:
+        with open(header_path, 'w') as f:
+            f.write(header)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,641 @@
+/**
+ * auth会话表主机性能测试
+ * 分别建立4、64和512个会话，测量auth_validate_session对有效和无效会话ID的耗时，
+ * 并检查登出、过期清理后其余会话仍可查到；再检查过期时间轮按时删除会话并测量每个刻度的开销；
+ * 然后以同样方式测量无状态令牌模式，
+ * 再测量旧版SHA-256和PBKDF2密码验证的耗时并检查哈希迁移，
+ * 再检查登录限速的突发容量、补充、指数锁定和记录替换，
+ * 再检查软件重启和断电重启后的会话恢复以及NVS写入预算，
+ * 最后对比旧版(malloc复制Cookie + strstr)和新版请求头解析加会话验证的每请求耗时，并检查API密钥
+ *
+ * 用法: auth_bench [重复次数]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "auth.h"
+#include "config_manager.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "esp_rtc_time.h"
+#include "esp_system.h"
+#include "nvs.h"
+
+static const int s_session_counts[] = { 4, 64, 512 };
+
+int64_t host_time_offset_us = 0;
+int64_t host_rtc_offset_us = 0;
+esp_reset_reason_t host_reset_reason = ESP_RST_POWERON;
+host_nvs_entry_t host_nvs[HOST_NVS_KEYS];
+int host_nvs_writes = 0;
+#define LEGACY_HASH_123456 "8d969eef6ecad3c29a3a629280e686cf0c3f5d5a86aff3ca12020c923adc6c92"
+
+static system_config_t s_config;
+
+/* auth.c只用到以下配置接口，默认账号admin/123456 */
+
+const system_config_t* config_manager_acquire(uint32_t* generation) {
+    if (generation) {
+        *generation = 1;
+    }
+    return &s_config;
+}
+
+void config_manager_release(const system_config_t* config) {
+    (void)config;
+}
+
+esp_err_t config_manager_get_auth(auth_config_t* config) {
+    *config = s_config.auth;
+    return ESP_OK;
+}
+
+esp_err_t config_manager_set_auth(const auth_config_t* config) {
+    s_config.auth = *config;
+    return ESP_OK;
+}
+
+esp_err_t config_manager_get_web_server(web_server_config_t* config) {
+    *config = s_config.web_server;
+    return ESP_OK;
+}
+
+static config_change_cb_t s_timeouts_cb = NULL;
+
+esp_err_t config_manager_subscribe(uint32_t sections, config_change_cb_t cb, void* arg) {
+    s_timeouts_cb = cb;
+    cb(sections, &s_config, arg);
+    return ESP_OK;
+}
+
+esp_err_t config_manager_unsubscribe(config_change_cb_t cb, void* arg) {
+    (void)cb;
+    (void)arg;
+    s_timeouts_cb = NULL;
+    return ESP_OK;
+}
+
+/**
+ * @brief 恢复默认账号：旧版SHA-256哈希，PBKDF2迭代次数iterations
+ */
+static void reset_auth(int iterations) {
+    strcpy(s_config.auth.username, "admin");
+    strcpy(s_config.auth.password_hash, LEGACY_HASH_123456);
+    s_config.auth.pbkdf2_iterations = iterations;
+    s_config.timeouts.session_max_age = 1800;
+    s_config.web_server.persist_sessions = 0;
+}
+
+/**
+ * @brief 单调时钟，单位纳秒
+ */
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "check failed at line %d: %s\n", __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+static void bench(int count, int rounds) {
+    char (*ids)[AUTH_SESSION_ID_LENGTH + 1] = malloc((size_t)count * sizeof(*ids));
+    char (*misses)[AUTH_SESSION_ID_LENGTH + 1] = malloc((size_t)count * sizeof(*misses));
+
+    reset_auth(1000);
+    s_config.web_server.max_sessions = count;
+    CHECK(auth_init() == ESP_OK);
+    for (int i = 0; i < count; i++) {
+        CHECK(auth_login("admin", "123456", ids[i]) == ESP_OK);
+        auth_generate_session_id(misses[i]);
+    }
+    char extra[AUTH_SESSION_ID_LENGTH + 1];
+    CHECK(auth_login("admin", "123456", extra) == ESP_ERR_NO_MEM);
+
+    double t = now_ns();
+    int valid = 0;
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < count; i++) {
+            valid += auth_validate_session(ids[i]);
+        }
+    }
+    double hit = (now_ns() - t) / rounds / count;
+    CHECK(valid == rounds * count);
+
+    t = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < count; i++) {
+            valid += auth_validate_session(misses[i]);
+        }
+    }
+    double miss = (now_ns() - t) / rounds / count;
+    CHECK(valid == rounds * count);
+
+    // 登出一半会话，其余会话不受删除时的移动影响
+    for (int i = 0; i < count; i += 2) {
+        CHECK(auth_logout(ids[i]) == ESP_OK);
+    }
+    for (int i = 0; i < count; i++) {
+        CHECK(auth_validate_session(ids[i]) == (i % 2 == 1));
+    }
+
+    // 剩余会话全部过期，清理后可以重新登录满
+    host_time_offset_us += ((int64_t)auth_get_session_timeout_ms() + AUTH_SESSION_WHEEL_TICK_MS) * 1000;
+    CHECK(auth_cleanup_expired_sessions() == count / 2);
+    for (int i = 0; i < count; i++) {
+        CHECK(auth_login("admin", "123456", ids[i]) == ESP_OK);
+    }
+    for (int i = 0; i < count; i++) {
+        CHECK(auth_validate_session(ids[i]));
+    }
+
+    auth_deinit();
+    printf("%8d %12.1f %12.1f\n", count, hit, miss);
+    free(ids);
+    free(misses);
+}
+
+/**
+ * @brief 会话是否仍在表中，不更新访问时间
+ */
+static bool session_exists(const char* id) {
+    auth_session_t info;
+    return auth_get_session_info(id, &info) == ESP_OK;
+}
+
+static void bench_wheel(int count) {
+    char (*ids)[AUTH_SESSION_ID_LENGTH + 1] = malloc((size_t)count * sizeof(*ids));
+    int64_t* login_ms = malloc((size_t)count * sizeof(*login_ms));
+
+    reset_auth(1000);
+    s_config.timeouts.session_max_age = 60;
+    s_config.web_server.max_sessions = count;
+    CHECK(auth_init() == ESP_OK);
+    CHECK(auth_get_session_timeout_ms() == 60000);
+
+    // 登录时间错开分布在一个超时周期内，留出登录本身耗费的真实时间，第一个会话在开始访问前不会过期
+    int64_t step_us = 50000000 / count;
+    for (int i = 0; i < count; i++) {
+        CHECK(auth_login("admin", "123456", ids[i]) == ESP_OK);
+        login_ms[i] = esp_timer_get_time() / 1000;
+        host_time_offset_us += step_us;
+    }
+
+    // 逐刻度推进两个超时周期：每4个会话中有1个一直被访问，其余会话到期后一个刻度内被删除
+    double t_total = 0;
+    int ticks = 0;
+    int expired = 0;
+    for (int tick = 0; tick < 120; tick++) {
+        for (int i = 0; i < count; i += 4) {
+            CHECK(auth_validate_session(ids[i]));
+        }
+        host_time_offset_us += AUTH_SESSION_WHEEL_TICK_MS * 1000;
+        double t = now_ns();
+        expired += auth_cleanup_expired_sessions();
+        t_total += now_ns() - t;
+        ticks++;
+
+        int64_t now = esp_timer_get_time() / 1000;
+        for (int i = 1; i < count; i++) {
+            if (i % 4 == 0) {
+                continue;
+            }
+            int64_t idle = now - login_ms[i];
+            if (idle <= 60000) {
+                CHECK(session_exists(ids[i]));
+            } else if (idle > 60000 + AUTH_SESSION_WHEEL_TICK_MS) {
+                CHECK(!session_exists(ids[i]));
+            }
+        }
+    }
+    CHECK(expired == count - (count + 3) / 4);
+
+    // 缩短超时立即对已有会话生效：按新超时已过期的会话在回调中删除，不等时间轮转一圈
+    host_time_offset_us += 2 * AUTH_SESSION_WHEEL_TICK_MS * 1000;
+    s_config.timeouts.session_max_age = 1;
+    s_timeouts_cb(CONFIG_SECTION_TIMEOUTS, &s_config, NULL);
+    for (int i = 0; i < count; i += 4) {
+        CHECK(!session_exists(ids[i]));
+    }
+    CHECK(auth_cleanup_expired_sessions() == 0);
+
+    // 定时器没有推进时间轮时，验证也按空闲时间拒绝过期会话
+    char late[AUTH_SESSION_ID_LENGTH + 1];
+    CHECK(auth_login("admin", "123456", late) == ESP_OK);
+    host_time_offset_us += 3 * AUTH_SESSION_WHEEL_TICK_MS * 1000;
+    CHECK(!auth_validate_session(late));
+    CHECK(!session_exists(late));
+
+    auth_deinit();
+    printf("wheel: %d sessions, %.1f ns per tick\n", count, t_total / ticks);
+    free(ids);
+    free(login_ms);
+}
+
+static void bench_tokens(int count, int rounds) {
+    char (*tokens)[AUTH_CREDENTIAL_MAX_LENGTH + 1] = malloc((size_t)count * sizeof(*tokens));
+    char (*forged)[AUTH_CREDENTIAL_MAX_LENGTH + 1] = malloc((size_t)count * sizeof(*forged));
+
+    // 会话表只有1项，令牌登录不受限制
+    reset_auth(1000);
+    s_config.web_server.max_sessions = 1;
+    s_config.web_server.stateless_sessions = 1;
+    CHECK(auth_init() == ESP_OK);
+    for (int i = 0; i < count; i++) {
+        CHECK(auth_login("admin", "123456", tokens[i]) == ESP_OK);
+        CHECK(strlen(tokens[i]) == AUTH_TOKEN_LENGTH);
+        strcpy(forged[i], tokens[i]);
+        forged[i][AUTH_TOKEN_LENGTH - 1] = forged[i][AUTH_TOKEN_LENGTH - 1] == '0' ? '1' : '0';
+    }
+
+    double t = now_ns();
+    int valid = 0;
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < count; i++) {
+            valid += auth_validate_session(tokens[i]);
+        }
+    }
+    double hit = (now_ns() - t) / rounds / count;
+    CHECK(valid == rounds * count);
+
+    t = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < count; i++) {
+            valid += auth_validate_session(forged[i]);
+        }
+    }
+    double miss = (now_ns() - t) / rounds / count;
+    CHECK(valid == rounds * count);
+
+    // 轮换一次后旧令牌仍然有效，签发满一个超时周期后过期
+    host_time_offset_us += (int64_t)auth_get_session_timeout_ms() * 1000 / 2;
+    char fresh[AUTH_CREDENTIAL_MAX_LENGTH + 1];
+    CHECK(auth_login("admin", "123456", fresh) == ESP_OK);
+    host_time_offset_us += (int64_t)auth_get_session_timeout_ms() * 1000 / 2 + 1000;
+    CHECK(!auth_validate_session(tokens[0]));
+    CHECK(auth_validate_session(fresh));
+
+    // 修改密码后全部令牌失效
+    CHECK(auth_change_password("admin", "123456", "123456") == ESP_OK);
+    CHECK(!auth_validate_session(fresh));
+
+    auth_deinit();
+    s_config.web_server.stateless_sessions = 0;
+    printf("%8s %12.1f %12.1f\n", "tokens", hit, miss);
+    free(tokens);
+    free(forged);
+}
+
+static void bench_password(int iterations, int rounds) {
+    reset_auth(iterations);
+    s_config.web_server.max_sessions = 1;
+    CHECK(auth_init() == ESP_OK);
+
+    // 旧版哈希验证成功一次后迁移为PBKDF2
+    double t = now_ns();
+    CHECK(auth_verify_password("admin", "123456"));
+    double legacy = now_ns() - t;
+    CHECK(strncmp(s_config.auth.password_hash, AUTH_PBKDF2_PREFIX, strlen(AUTH_PBKDF2_PREFIX)) == 0);
+    char migrated[sizeof(s_config.auth.password_hash)];
+    strcpy(migrated, s_config.auth.password_hash);
+
+    t = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        CHECK(auth_verify_password("admin", "123456"));
+        CHECK(!auth_verify_password("admin", "1234567"));
+    }
+    double pbkdf2 = (now_ns() - t) / rounds / 2;
+    CHECK(strcmp(s_config.auth.password_hash, migrated) == 0);
+
+    // 迭代次数变化后下次登录重新计算，修改密码使用新的盐
+    s_config.auth.pbkdf2_iterations = iterations * 2;
+    CHECK(auth_verify_password("admin", "123456"));
+    CHECK(strcmp(s_config.auth.password_hash, migrated) != 0);
+    CHECK(auth_change_password("admin", "123456", "654321") == ESP_OK);
+    CHECK(!auth_verify_password("admin", "123456"));
+    CHECK(auth_verify_password("admin", "654321"));
+
+    auth_deinit();
+    printf("password: legacy sha256 + migrate %.0f us, pbkdf2 %d iterations %.0f us\n",
+           legacy / 1000, iterations, pbkdf2 / 1000);
+}
+
+static void bench_throttle(int rounds) {
+    uint8_t client[AUTH_CLIENT_ADDR_BYTES] = { 0 };
+    uint32_t retry = 0;
+    client[0] = 1;
+
+    // 突发容量用完后按补充间隔放行
+    for (int i = 0; i < AUTH_LOGIN_BURST; i++) {
+        CHECK(auth_login_throttle_allow(client, &retry));
+    }
+    CHECK(!auth_login_throttle_allow(client, &retry));
+    CHECK(retry > 0 && retry <= AUTH_LOGIN_REFILL_MS);
+    host_time_offset_us += (int64_t)retry * 1000;
+    CHECK(auth_login_throttle_allow(client, &retry));
+    CHECK(!auth_login_throttle_allow(client, &retry));
+
+    // 连续失败达到阈值后锁定，之后每次失败锁定时长翻倍，直到上限
+    host_time_offset_us += (int64_t)AUTH_LOGIN_REFILL_MS * AUTH_LOGIN_BURST * 1000;
+    uint32_t lockout = AUTH_LOGIN_LOCKOUT_BASE_MS;
+    for (int i = 1; i <= AUTH_LOGIN_LOCKOUT_THRESHOLD + 8; i++) {
+        auth_login_throttle_record(client, false);
+        if (i < AUTH_LOGIN_LOCKOUT_THRESHOLD) {
+            continue;
+        }
+        CHECK(!auth_login_throttle_allow(client, &retry));
+        CHECK(retry == lockout);
+        lockout = lockout * 2 > AUTH_LOGIN_LOCKOUT_MAX_MS ? AUTH_LOGIN_LOCKOUT_MAX_MS : lockout * 2;
+    }
+    host_time_offset_us += (int64_t)AUTH_LOGIN_LOCKOUT_MAX_MS * 1000;
+    CHECK(auth_login_throttle_allow(client, &retry));
+
+    // 登录成功清除失败计数
+    auth_login_throttle_record(client, true);
+    for (int i = 1; i < AUTH_LOGIN_LOCKOUT_THRESHOLD; i++) {
+        auth_login_throttle_record(client, false);
+    }
+    CHECK(auth_login_throttle_allow(client, &retry));
+
+    // 记录表满时替换最久未出现的客户端，被锁定的客户端保留
+    auth_login_throttle_record(client, false);
+    for (int i = 0; i < AUTH_THROTTLE_CLIENTS * 4; i++) {
+        uint8_t other[AUTH_CLIENT_ADDR_BYTES] = { 0 };
+        other[0] = 2;
+        other[1] = (uint8_t)i;
+        CHECK(auth_login_throttle_allow(other, &retry));
+    }
+    CHECK(!auth_login_throttle_allow(client, &retry));
+
+    // 每次请求的拒绝开销
+    double t = now_ns();
+    int allowed = 0;
+    for (int r = 0; r < rounds; r++) {
+        allowed += auth_login_throttle_allow(client, &retry);
+    }
+    double reject = (now_ns() - t) / rounds;
+    CHECK(allowed == 0);
+
+    auth_deinit();
+    printf("throttle: reject %.1f ns\n", reject);
+}
+
+/**
+ * @brief 模拟重启：esp_timer归零，软件重启时RTC时间继续走过downtime_ms，断电时RTC时间也归零
+ */
+static void reboot(esp_reset_reason_t reason, int64_t downtime_ms) {
+    auth_deinit();
+    int64_t uptime_us = esp_timer_get_time();
+    host_time_offset_us -= uptime_us;
+    if (reason == ESP_RST_POWERON) {
+        host_rtc_offset_us = -esp_timer_get_time();
+    } else {
+        host_rtc_offset_us += uptime_us + downtime_ms * 1000;
+    }
+    host_reset_reason = reason;
+    CHECK(auth_init() == ESP_OK);
+}
+
+static void bench_persist(void) {
+    char a[AUTH_CREDENTIAL_MAX_LENGTH + 1];
+    char b[AUTH_CREDENTIAL_MAX_LENGTH + 1];
+    char c[AUTH_CREDENTIAL_MAX_LENGTH + 1];
+
+    reset_auth(1000);
+    s_config.web_server.max_sessions = 8;
+    s_config.web_server.persist_sessions = 1;
+    host_reset_reason = ESP_RST_POWERON;
+    memset(host_nvs, 0, sizeof(host_nvs));
+    host_nvs_writes = 0;
+    CHECK(auth_init() == ESP_OK);
+    CHECK(auth_login("admin", "123456", a) == ESP_OK);
+    CHECK(auth_login("admin", "123456", b) == ESP_OK);
+    CHECK(auth_login("admin", "123456", c) == ESP_OK);
+
+    // 登录后等满间隔才写NVS，登出立即写入，只有访问时间变化时等更长的间隔
+    CHECK(auth_save_sessions() == ESP_OK && host_nvs_writes == 0);
+    host_time_offset_us += (int64_t)AUTH_PERSIST_NVS_INTERVAL_MS * 1000;
+    CHECK(auth_save_sessions() == ESP_OK && host_nvs_writes == 1);
+    CHECK(auth_save_sessions() == ESP_OK && host_nvs_writes == 1);
+    CHECK(auth_logout(b) == ESP_OK && host_nvs_writes == 2);
+    CHECK(auth_save_sessions() == ESP_OK && host_nvs_writes == 2);
+    CHECK(auth_validate_session(a));
+    host_time_offset_us += (int64_t)AUTH_PERSIST_NVS_INTERVAL_MS * 1000;
+    CHECK(auth_save_sessions() == ESP_OK && host_nvs_writes == 2);
+    host_time_offset_us += (int64_t)AUTH_PERSIST_TOUCH_INTERVAL_MS * 1000;
+    CHECK(auth_validate_session(a));
+    CHECK(auth_save_sessions() == ESP_OK && host_nvs_writes == 3);
+
+    // 软件重启从RTC镜像恢复，重启耗时计入空闲时间：c自登录后没有访问，按原时间过期
+    int64_t c_idle_ms = AUTH_PERSIST_NVS_INTERVAL_MS * 2 + AUTH_PERSIST_TOUCH_INTERVAL_MS;
+    reboot(ESP_RST_SW, 5000);
+    c_idle_ms += 5000;
+    CHECK(auth_validate_session(a));
+    CHECK(!auth_validate_session(b));
+    host_time_offset_us += ((int64_t)auth_get_session_timeout_ms() - c_idle_ms - 2 * AUTH_SESSION_WHEEL_TICK_MS) * 1000;
+    CHECK(auth_validate_session(a));
+    auth_cleanup_expired_sessions();
+    CHECK(session_exists(c));
+    host_time_offset_us += 4 * AUTH_SESSION_WHEEL_TICK_MS * 1000;
+    auth_cleanup_expired_sessions();
+    CHECK(!session_exists(c));
+    CHECK(auth_validate_session(a));
+
+    // 断电重启从NVS镜像恢复：登出后不等写入间隔就断电，登出的会话也不应恢复
+    CHECK(auth_login("admin", "123456", b) == ESP_OK);
+    CHECK(auth_login("admin", "123456", c) == ESP_OK);
+    host_time_offset_us += (int64_t)AUTH_PERSIST_NVS_INTERVAL_MS * 1000;
+    int writes = host_nvs_writes;
+    CHECK(auth_save_sessions() == ESP_OK && host_nvs_writes == writes + 1);
+    CHECK(auth_logout(a) == ESP_OK && host_nvs_writes == writes + 2);
+    reboot(ESP_RST_POWERON, 24LL * 3600 * 1000);
+    CHECK(!auth_validate_session(a));
+    CHECK(auth_validate_session(b));
+
+    // 断电时长无法得知，恢复的会话只剩宽限期：断电后没有再访问的c在宽限期后过期
+    CHECK(session_exists(c));
+    host_time_offset_us += ((int64_t)AUTH_PERSIST_POWERON_GRACE_MS + 2 * AUTH_SESSION_WHEEL_TICK_MS) * 1000;
+    auth_cleanup_expired_sessions();
+    CHECK(!session_exists(c));
+    CHECK(auth_validate_session(b));
+
+    // 账号改名后不恢复
+    strcpy(s_config.auth.username, "root");
+    reboot(ESP_RST_SW, 1000);
+    CHECK(!session_exists(b));
+    strcpy(s_config.auth.username, "admin");
+
+    // 令牌在软件重启后仍然有效
+    s_config.web_server.stateless_sessions = 1;
+    reboot(ESP_RST_SW, 1000);
+    char token[AUTH_CREDENTIAL_MAX_LENGTH + 1];
+    CHECK(auth_login("admin", "123456", token) == ESP_OK);
+    reboot(ESP_RST_SW, 1000);
+    CHECK(auth_validate_session(token));
+    s_config.web_server.stateless_sessions = 0;
+
+    // 关闭持久化后删除镜像，重新打开也不会恢复
+    s_config.web_server.max_sessions = 8;
+    reboot(ESP_RST_SW, 1000);
+    CHECK(auth_login("admin", "123456", c) == ESP_OK);
+    s_config.web_server.persist_sessions = 0;
+    reboot(ESP_RST_SW, 1000);
+    CHECK(!host_nvs_find("sessions", 0));
+    s_config.web_server.persist_sessions = 1;
+    reboot(ESP_RST_SW, 1000);
+    CHECK(!session_exists(c));
+
+    auth_deinit();
+    host_reset_reason = ESP_RST_POWERON;
+    printf("persist: %d NVS writes\n", host_nvs_writes);
+}
+
+/**
+ * @brief 修改前web_server中get_session_id_from_header的解析部分：复制整个Cookie头到堆上再strstr
+ * @note 原实现还要先调用一次httpd_req_get_hdr_value_len扫描请求头，这里没有计入
+ */
+static esp_err_t legacy_parse_cookie(const char* header, char* session_id) {
+    size_t buf_len = strlen(header);
+    char* buf = malloc(buf_len + 1);
+    if (!buf) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(buf, header, buf_len + 1);
+
+    char* session_start = strstr(buf, "session_id=");
+    if (!session_start) {
+        free(buf);
+        return ESP_ERR_NOT_FOUND;
+    }
+    session_start += strlen("session_id=");
+    char* session_end = strchr(session_start, ';');
+    int session_len = session_end ? (session_end - session_start) : (int)strlen(session_start);
+    if (session_len > AUTH_CREDENTIAL_MAX_LENGTH) {
+        session_len = AUTH_CREDENTIAL_MAX_LENGTH;
+    }
+    strncpy(session_id, session_start, session_len);
+    session_id[session_len] = '\0';
+    free(buf);
+    return ESP_OK;
+}
+
+/**
+ * @brief 每请求的解析加验证耗时(ns)
+ */
+static double time_request(esp_err_t (*parse)(const char*, char*), const char* header, int rounds) {
+    char credential[AUTH_CREDENTIAL_MAX_LENGTH + 1];
+    int valid = 0;
+    double t = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        valid += parse(header, credential) == ESP_OK && auth_validate_session(credential);
+    }
+    double elapsed = (now_ns() - t) / rounds;
+    CHECK(valid == rounds);
+    return elapsed;
+}
+
+static void bench_credentials(int rounds) {
+    char id[AUTH_CREDENTIAL_MAX_LENGTH + 1];
+    char credential[AUTH_CREDENTIAL_MAX_LENGTH + 1];
+    char header[512];
+
+    reset_auth(1000);
+    s_config.web_server.max_sessions = 2;
+    memset(host_nvs, 0, sizeof(host_nvs));
+    CHECK(auth_init() == ESP_OK);
+    CHECK(auth_login("admin", "123456", id) == ESP_OK);
+
+    // 名称必须完全匹配，前后空白去掉，过长的值拒绝而不是截断
+    snprintf(header, sizeof(header), "xsession_id=bad; session_id=%s ; lang=zh", id);
+    CHECK(auth_parse_cookie(header, credential) == ESP_OK && strcmp(credential, id) == 0);
+    CHECK(legacy_parse_cookie(header, credential) == ESP_OK && strcmp(credential, "bad") == 0);
+    CHECK(auth_parse_cookie("lang=zh; session=abc", credential) == ESP_ERR_NOT_FOUND);
+    CHECK(auth_parse_cookie("session_id=0123456789012345678901234567890123456789012345678901234567890123",
+                            credential) == ESP_ERR_INVALID_SIZE);
+    snprintf(header, sizeof(header), "bearer  %s", id);
+    CHECK(auth_parse_bearer(header, credential) == ESP_OK && strcmp(credential, id) == 0);
+    CHECK(auth_parse_bearer("Basic YWRtaW46MTIzNDU2", credential) == ESP_ERR_NOT_FOUND);
+    CHECK(auth_parse_bearer("Bearer a b", credential) == ESP_ERR_NOT_FOUND);
+
+    printf("%-40s %10s %10s\n", "is_authenticated per request", "old(ns)", "new(ns)");
+    const char* formats[] = { "session_id=%s", "lang=zh-CN; theme=dark; session_id=%s; _ga=GA1.2.1234567890.1700000000" };
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        snprintf(header, sizeof(header), formats[i], id);
+        double legacy = time_request(legacy_parse_cookie, header, rounds);
+        double current = time_request(auth_parse_cookie, header, rounds);
+        printf("  cookie %-31s %10.1f %10.1f\n", i == 0 ? "(session_id only)" : "(4 cookies)", legacy, current);
+    }
+
+    // API密钥与会话共用会话表，不占用max_sessions，不过期
+    char key[AUTH_API_KEY_LENGTH + 1];
+    char other[AUTH_API_KEY_LENGTH + 1];
+    CHECK(auth_create_api_key("ci", key) == ESP_OK);
+    CHECK(auth_is_api_key(key) && strlen(key) == AUTH_API_KEY_LENGTH);
+    CHECK(auth_create_api_key("ci", other) == ESP_ERR_INVALID_STATE);
+    CHECK(auth_create_api_key("", other) == ESP_ERR_INVALID_ARG);
+    CHECK(auth_login("admin", "123456", credential) == ESP_OK);
+    CHECK(auth_login("admin", "123456", credential) == ESP_ERR_NO_MEM);
+    snprintf(header, sizeof(header), "Bearer %s", key);
+    double bearer = time_request(auth_parse_bearer, header, rounds);
+    printf("  bearer %-31s %10s %10.1f\n", "(API key, SHA-256 + lookup)", "-", bearer);
+
+    for (int i = 1; i < AUTH_MAX_API_KEYS; i++) {
+        char name[8];
+        snprintf(name, sizeof(name), "k%d", i);
+        CHECK(auth_create_api_key(name, other) == ESP_OK);
+    }
+    CHECK(auth_create_api_key("full", other) == ESP_ERR_NO_MEM);
+    auth_api_key_info_t keys[AUTH_MAX_API_KEYS];
+    CHECK(auth_list_api_keys(keys, AUTH_MAX_API_KEYS) == AUTH_MAX_API_KEYS);
+    CHECK(strcmp(keys[0].name, "ci") == 0 && keys[0].used && !keys[1].used);
+
+    // 会话全部过期后密钥仍然有效，会话删除时移动的表项不影响密钥
+    host_time_offset_us += ((int64_t)auth_get_session_timeout_ms() + 2 * AUTH_SESSION_WHEEL_TICK_MS) * 1000;
+    CHECK(auth_cleanup_expired_sessions() == 2);
+    CHECK(auth_validate_session(key) && auth_validate_session(other));
+    CHECK(!auth_validate_session(id));
+    CHECK(auth_logout(key) == ESP_ERR_NOT_FOUND);
+
+    // 密钥写入NVS，重启后仍然有效，与persist_sessions无关；吊销立即生效并写入NVS
+    reboot(ESP_RST_POWERON, 1000);
+    CHECK(auth_validate_session(key) && auth_validate_session(other));
+    CHECK(auth_revoke_api_key("ci") == ESP_OK);
+    CHECK(auth_revoke_api_key("ci") == ESP_ERR_NOT_FOUND);
+    CHECK(!auth_validate_session(key) && auth_validate_session(other));
+    reboot(ESP_RST_POWERON, 1000);
+    CHECK(!auth_validate_session(key) && auth_validate_session(other));
+    CHECK(auth_list_api_keys(keys, AUTH_MAX_API_KEYS) == AUTH_MAX_API_KEYS - 1);
+    key[5] ^= 1;
+    CHECK(!auth_validate_session(key));
+
+    auth_deinit();
+    memset(host_nvs, 0, sizeof(host_nvs));
+    host_reset_reason = ESP_RST_POWERON;
+}
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 2000;
+    if (rounds <= 0) {
+        rounds = 2000;
+    }
+
+    printf("auth session host benchmark, %d rounds\n", rounds);
+    printf("%8s %12s %12s\n", "sessions", "valid(ns)", "invalid(ns)");
+    for (size_t i = 0; i < sizeof(s_session_counts) / sizeof(s_session_counts[0]); i++) {
+        bench(s_session_counts[i], rounds);
+    }
+    bench_wheel(512);
+    bench_tokens(512, rounds / 10 > 0 ? rounds / 10 : 1);
+    bench_password(10000, 5);
+    bench_throttle(rounds * 100);
+    bench_persist();
+    bench_credentials(rounds * 100);
+    return 0;
+}
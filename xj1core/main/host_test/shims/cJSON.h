@@ -0,0 +1,10 @@
+/**
+ * 主机构建用的cJSON.h替身，只提供config_manager.h声明中用到的类型
+ */
+
+#ifndef HOST_CJSON_H
+#define HOST_CJSON_H
+
+typedef struct cJSON cJSON;
+
+#endif // HOST_CJSON_H
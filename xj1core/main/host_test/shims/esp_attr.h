@@ -0,0 +1,11 @@
+/**
+ * 主机构建用的esp_attr.h替身，RTC_NOINIT变量就是普通静态变量，
+ * 测试中auth_deinit后再auth_init即模拟内容保留的软件重启
+ */
+
+#ifndef HOST_ESP_ATTR_H
+#define HOST_ESP_ATTR_H
+
+#define RTC_NOINIT_ATTR
+
+#endif // HOST_ESP_ATTR_H
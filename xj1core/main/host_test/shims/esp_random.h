@@ -0,0 +1,26 @@
+/**
+ * 主机构建用的esp_random.h替身，随机数取自/dev/urandom
+ */
+
+#ifndef HOST_ESP_RANDOM_H
+#define HOST_ESP_RANDOM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+static inline void esp_fill_random(void* buf, size_t len) {
+    FILE* f = fopen("/dev/urandom", "rb");
+    if (!f || fread(buf, 1, len, f) != len) {
+        abort();
+    }
+    fclose(f);
+}
+
+static inline uint32_t esp_random(void) {
+    uint32_t value;
+    esp_fill_random(&value, sizeof(value));
+    return value;
+}
+
+#endif // HOST_ESP_RANDOM_H
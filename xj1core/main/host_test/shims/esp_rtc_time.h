@@ -0,0 +1,18 @@
+/**
+ * 主机构建用的esp_rtc_time.h替身，返回esp_timer时间加上host_rtc_offset_us，
+ * 测试修改host_time_offset_us时两者一起前进，重启时只让esp_timer归零
+ */
+
+#ifndef HOST_ESP_RTC_TIME_H
+#define HOST_ESP_RTC_TIME_H
+
+#include <stdint.h>
+#include "esp_timer.h"
+
+extern int64_t host_rtc_offset_us;
+
+static inline uint64_t esp_rtc_get_time_us(void) {
+    return (uint64_t)(esp_timer_get_time() + host_rtc_offset_us);
+}
+
+#endif // HOST_ESP_RTC_TIME_H
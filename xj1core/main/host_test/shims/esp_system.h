@@ -0,0 +1,28 @@
+/**
+ * 主机构建用的esp_system.h替身，复位原因由测试通过host_reset_reason设置
+ */
+
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+typedef enum {
+    ESP_RST_UNKNOWN,
+    ESP_RST_POWERON,
+    ESP_RST_EXT,
+    ESP_RST_SW,
+    ESP_RST_PANIC,
+    ESP_RST_INT_WDT,
+    ESP_RST_TASK_WDT,
+    ESP_RST_WDT,
+    ESP_RST_DEEPSLEEP,
+    ESP_RST_BROWNOUT,
+    ESP_RST_SDIO,
+} esp_reset_reason_t;
+
+extern esp_reset_reason_t host_reset_reason;
+
+static inline esp_reset_reason_t esp_reset_reason(void) {
+    return host_reset_reason;
+}
+
+#endif // HOST_ESP_SYSTEM_H
@@ -0,0 +1,73 @@
+/**
+ * 主机构建用的esp_timer.h替身，返回单调时钟加上host_time_offset_us，
+ * 测试可以通过修改偏移模拟时间流逝。定时器只记录启停状态，不会自动触发回调，
+ * 测试直接调用被测模块的处理函数模拟定时器到期
+ */
+
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include "esp_err.h"
+
+extern int64_t host_time_offset_us;
+
+static inline int64_t esp_timer_get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000 + host_time_offset_us;
+}
+
+typedef void (*esp_timer_cb_t)(void* arg);
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void* arg;
+    const char* name;
+} esp_timer_create_args_t;
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    bool active;
+};
+
+typedef struct esp_timer* esp_timer_handle_t;
+
+static inline esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+    struct esp_timer* timer = calloc(1, sizeof(struct esp_timer));
+    if (!timer) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->callback = args->callback;
+    timer->arg = args->arg;
+    *out = timer;
+    return ESP_OK;
+}
+
+static inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+    (void)period_us;
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = true;
+    return ESP_OK;
+}
+
+static inline esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    return ESP_OK;
+}
+
+static inline esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    free(timer);
+    return ESP_OK;
+}
+
+#endif // HOST_ESP_TIMER_H
@@ -0,0 +1,17 @@
+/**
+ * 主机构建用的FreeRTOS.h替身，只提供互斥锁用到的类型和常量
+ */
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+#define pdTRUE 1
+#define pdFALSE 0
+
+#endif // HOST_FREERTOS_H
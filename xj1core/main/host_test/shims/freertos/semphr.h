@@ -0,0 +1,36 @@
+/**
+ * 主机构建用的semphr.h替身，互斥锁由pthread实现，不支持超时
+ */
+
+#ifndef HOST_SEMPHR_H
+#define HOST_SEMPHR_H
+
+#include <pthread.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+
+typedef pthread_mutex_t* SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    SemaphoreHandle_t mutex = malloc(sizeof(pthread_mutex_t));
+    if (mutex) {
+        pthread_mutex_init(mutex, NULL);
+    }
+    return mutex;
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks) {
+    (void)ticks;
+    return pthread_mutex_lock(mutex) == 0 ? pdTRUE : pdFALSE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+    return pthread_mutex_unlock(mutex) == 0 ? pdTRUE : pdFALSE;
+}
+
+static inline void vSemaphoreDelete(SemaphoreHandle_t mutex) {
+    pthread_mutex_destroy(mutex);
+    free(mutex);
+}
+
+#endif // HOST_SEMPHR_H
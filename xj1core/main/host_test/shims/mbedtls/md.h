@@ -0,0 +1,34 @@
+/**
+ * 主机构建用的mbedtls/md.h替身，只提供HMAC-SHA256，由OpenSSL实现
+ */
+
+#ifndef HOST_MBEDTLS_MD_H
+#define HOST_MBEDTLS_MD_H
+
+#include <stddef.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+typedef enum {
+    MBEDTLS_MD_NONE = 0,
+    MBEDTLS_MD_SHA256 = 6,
+} mbedtls_md_type_t;
+
+typedef struct {
+    mbedtls_md_type_t type;
+} mbedtls_md_info_t;
+
+static inline const mbedtls_md_info_t* mbedtls_md_info_from_type(mbedtls_md_type_t type) {
+    static const mbedtls_md_info_t sha256 = { MBEDTLS_MD_SHA256 };
+    return type == MBEDTLS_MD_SHA256 ? &sha256 : NULL;
+}
+
+static inline int mbedtls_md_hmac(const mbedtls_md_info_t* info, const unsigned char* key, size_t keylen,
+                                  const unsigned char* input, size_t ilen, unsigned char* output) {
+    if (!info) {
+        return -1;
+    }
+    return HMAC(EVP_sha256(), key, (int)keylen, input, ilen, output, NULL) ? 0 : -1;
+}
+
+#endif // HOST_MBEDTLS_MD_H
@@ -0,0 +1,23 @@
+/**
+ * 主机构建用的mbedtls/pkcs5.h替身，只提供PBKDF2-HMAC-SHA256，由OpenSSL实现
+ */
+
+#ifndef HOST_MBEDTLS_PKCS5_H
+#define HOST_MBEDTLS_PKCS5_H
+
+#include <stdint.h>
+#include "mbedtls/md.h"
+
+static inline int mbedtls_pkcs5_pbkdf2_hmac_ext(mbedtls_md_type_t md_type,
+                                                const unsigned char* password, size_t plen,
+                                                const unsigned char* salt, size_t slen,
+                                                unsigned int iteration_count,
+                                                uint32_t key_length, unsigned char* output) {
+    if (md_type != MBEDTLS_MD_SHA256) {
+        return -1;
+    }
+    return PKCS5_PBKDF2_HMAC((const char*)password, (int)plen, salt, (int)slen, (int)iteration_count,
+                             EVP_sha256(), (int)key_length, output) == 1 ? 0 : -1;
+}
+
+#endif // HOST_MBEDTLS_PKCS5_H
@@ -0,0 +1,36 @@
+/**
+ * 主机构建用的mbedtls/sha256.h替身，接口与ESP-IDF中的mbedtls 3.x相同，由OpenSSL实现
+ */
+
+#ifndef HOST_MBEDTLS_SHA256_H
+#define HOST_MBEDTLS_SHA256_H
+
+#include <stddef.h>
+#include <openssl/evp.h>
+
+typedef struct {
+    EVP_MD_CTX* ctx;
+} mbedtls_sha256_context;
+
+static inline void mbedtls_sha256_init(mbedtls_sha256_context* ctx) {
+    ctx->ctx = EVP_MD_CTX_new();
+}
+
+static inline void mbedtls_sha256_free(mbedtls_sha256_context* ctx) {
+    EVP_MD_CTX_free(ctx->ctx);
+    ctx->ctx = NULL;
+}
+
+static inline int mbedtls_sha256_starts(mbedtls_sha256_context* ctx, int is224) {
+    return EVP_DigestInit_ex(ctx->ctx, is224 ? EVP_sha224() : EVP_sha256(), NULL) == 1 ? 0 : -1;
+}
+
+static inline int mbedtls_sha256_update(mbedtls_sha256_context* ctx, const unsigned char* input, size_t len) {
+    return EVP_DigestUpdate(ctx->ctx, input, len) == 1 ? 0 : -1;
+}
+
+static inline int mbedtls_sha256_finish(mbedtls_sha256_context* ctx, unsigned char* output) {
+    return EVP_DigestFinal_ex(ctx->ctx, output, NULL) == 1 ? 0 : -1;
+}
+
+#endif // HOST_MBEDTLS_SHA256_H
@@ -0,0 +1,106 @@
+/**
+ * 主机构建用的nvs.h替身，按键名保存少量blob，不区分命名空间，
+ * 内容和写入次数放在测试定义的host_nvs_*变量中
+ */
+
+#ifndef HOST_NVS_H
+#define HOST_NVS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "esp_err.h"
+
+#define ESP_ERR_NVS_NOT_FOUND 0x1102
+#define HOST_NVS_BLOB_MAX 4096
+#define HOST_NVS_KEYS 4
+
+typedef uint32_t nvs_handle_t;
+
+typedef enum {
+    NVS_READONLY,
+    NVS_READWRITE,
+} nvs_open_mode_t;
+
+typedef struct {
+    char key[16];
+    uint8_t data[HOST_NVS_BLOB_MAX];
+    size_t length;                          // 0表示没有保存
+} host_nvs_entry_t;
+
+extern host_nvs_entry_t host_nvs[HOST_NVS_KEYS];
+extern int host_nvs_writes;
+
+/**
+ * @brief 查找键名，create为true时不存在则占用空位
+ */
+static inline host_nvs_entry_t* host_nvs_find(const char* key, int create) {
+    host_nvs_entry_t* free_entry = NULL;
+    for (int i = 0; i < HOST_NVS_KEYS; i++) {
+        if (host_nvs[i].length > 0 && strcmp(host_nvs[i].key, key) == 0) {
+            return &host_nvs[i];
+        }
+        if (host_nvs[i].length == 0 && !free_entry) {
+            free_entry = &host_nvs[i];
+        }
+    }
+    if (create && free_entry) {
+        strncpy(free_entry->key, key, sizeof(free_entry->key) - 1);
+        return free_entry;
+    }
+    return NULL;
+}
+
+static inline esp_err_t nvs_open(const char* name, nvs_open_mode_t mode, nvs_handle_t* handle) {
+    (void)name;
+    (void)mode;
+    *handle = 1;
+    return ESP_OK;
+}
+
+static inline void nvs_close(nvs_handle_t handle) {
+    (void)handle;
+}
+
+static inline esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* value, size_t* length) {
+    (void)handle;
+    host_nvs_entry_t* entry = host_nvs_find(key, 0);
+    if (!entry) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (*length < entry->length) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(value, entry->data, entry->length);
+    *length = entry->length;
+    return ESP_OK;
+}
+
+static inline esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+    (void)handle;
+    host_nvs_entry_t* entry = host_nvs_find(key, 1);
+    if (!entry || length == 0 || length > HOST_NVS_BLOB_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(entry->data, value, length);
+    entry->length = length;
+    host_nvs_writes++;
+    return ESP_OK;
+}
+
+static inline esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+    (void)handle;
+    host_nvs_entry_t* entry = host_nvs_find(key, 0);
+    if (!entry) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    entry->length = 0;
+    return ESP_OK;
+}
+
+static inline esp_err_t nvs_commit(nvs_handle_t handle) {
+    (void)handle;
+    return ESP_OK;
+}
+
+#endif // HOST_NVS_H
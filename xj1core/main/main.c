@@ -48,12 +48,31 @@ static const char *TAG = "main";
 static TaskHandle_t status_update_task_handle = NULL;
 // static TaskHandle_t wifi_scan_task_handle = NULL; // 已禁用WiFi扫描任务
 
+// 状态更新间隔，由配置变化回调更新
+static volatile int g_status_update_interval = 5000;
+
+/**
+ * @brief 间隔配置变化回调，更新缓存的间隔并唤醒状态更新任务使新间隔立即生效
+ */
+static void on_intervals_changed(uint32_t sections, const system_config_t* config, void* arg) {
+    int interval = config->intervals.status_update_interval;
+    if (interval != g_status_update_interval) {
+        g_status_update_interval = interval;
+        xTaskNotifyGive((TaskHandle_t)arg);
+    }
+}
+
 /**
  * @brief 状态更新任务
  */
 static void status_update_task(void *pvParameters) {
     network_status_t status;
     
+    if (config_manager_subscribe(CONFIG_SECTION_INTERVALS, on_intervals_changed,
+                                 xTaskGetCurrentTaskHandle()) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to subscribe interval config, using %d ms", g_status_update_interval);
+    }
+    
     while (1) {
         // 获取各模块状态
         memset(&status, 0, sizeof(network_status_t));
@@ -105,17 +124,11 @@ static void status_update_task(void *pvParameters) {
         // 更新Web服务器状态
         web_server_update_network_status(&status);
         
-        // 清理过期的认证会话
-        auth_cleanup_expired_sessions();
-        
-        // 获取状态更新间隔配置
-        interval_config_t interval_config;
-        int update_interval = 5000; // 默认值
-        if (config_manager_get_intervals(&interval_config) == ESP_OK) {
-            update_interval = interval_config.status_update_interval;
-        }
+        // 按写入预算把会话保存到NVS
+        auth_save_sessions();
         
-        vTaskDelay(pdMS_TO_TICKS(update_interval));
+        // 等待下一个周期，间隔修改时提前唤醒
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(g_status_update_interval));
     }
 }
 
@@ -18,6 +18,9 @@
  */
 
 #include "mqtt_manager.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "config_manager.h"
 #include "wifi_manager.h"
 #include "esp_log.h"
@@ -35,33 +38,232 @@ static bool g_mqtt_connected = false;
 static int g_message_count = 0;
 static TaskHandle_t g_heartbeat_task_handle = NULL;
 static TaskHandle_t g_mqtt_monitor_task_handle = NULL;
+static bool g_mqtt_started = false;
+static int64_t g_reconnect_start_us = 0;  // 配置修改触发重连的时间，连接成功时统计中断时长
 
-// 师生通信主题变量（从配置文件读取）
+// 客户端当前使用的配置，用于判断修改需要重连还是只需更新参数和改订主题，只在监控任务中读写
+static mqtt_config_t g_applied_mqtt;
+static timeout_config_t g_applied_timeouts;
+
+// 配置变化回调缓存的新配置，受g_topic_mutex保护，由监控任务应用到客户端
+static mqtt_config_t g_pending_mqtt;
+static timeout_config_t g_pending_timeouts;
+static bool g_config_pending = false;
+
+// 师生通信主题变量（由配置变化回调更新），受g_topic_mutex保护
+static SemaphoreHandle_t g_topic_mutex = NULL;
 static char g_topic_student_to_teacher[64] = "xj1core/student/message";
 static char g_topic_teacher_to_student[64] = "xj1cloud/teacher/message";
 static char g_topic_student_heartbeat[64] = "xj1core/heartbeat";
 static char g_topic_student_status[64] = "xj1core/status";
 
+// 任务周期（由配置变化回调更新）
+static volatile int g_heartbeat_interval = 5000;
+static volatile int g_monitor_interval = 10000;
 
 /**
- * @brief 从配置文件加载MQTT主题
+ * @brief 拷贝一个主题，避免使用时被配置变化回调修改
  */
-static void load_mqtt_topics_from_config(void) {
-    mqtt_config_t mqtt_config;
-    esp_err_t ret = config_manager_get_mqtt(&mqtt_config);
-    if (ret == ESP_OK) {
-        strcpy(g_topic_student_to_teacher, mqtt_config.topic_student_to_teacher);
-        strcpy(g_topic_teacher_to_student, mqtt_config.topic_teacher_to_student);
-        strcpy(g_topic_student_heartbeat, mqtt_config.topic_student_heartbeat);
-        strcpy(g_topic_student_status, mqtt_config.topic_student_status);
+static void copy_topic(char* dst, const char* topic) {
+    xSemaphoreTake(g_topic_mutex, portMAX_DELAY);
+    strcpy(dst, topic);
+    xSemaphoreGive(g_topic_mutex);
+}
+
+/**
+ * @brief 更新间隔缓存，间隔变化时唤醒对应任务使新间隔立即生效
+ */
+static void update_interval(volatile int* cached, int interval, TaskHandle_t task) {
+    if (interval != *cached) {
+        *cached = interval;
+        if (task) {
+            xTaskNotifyGive(task);
+        }
+    }
+}
+
+/**
+ * @brief 检查MQTT配置完整性
+ */
+static esp_err_t validate_mqtt_config(const mqtt_config_t* mqtt) {
+    if (strlen(mqtt->broker_host) == 0) {
+        ESP_LOGE(TAG, "MQTT broker_host为空，请检查config.ini配置");
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (mqtt->broker_port <= 0 || mqtt->broker_port > 65535) {
+        ESP_LOGE(TAG, "MQTT broker_port无效: %d，请检查config.ini配置", mqtt->broker_port);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (strlen(mqtt->client_id) == 0) {
+        ESP_LOGE(TAG, "MQTT client_id为空，请检查config.ini配置");
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 由配置生成MQTT客户端参数，初始化和热更新共用
+ * @param uri 输出URI缓冲区，需在使用cfg期间有效
+ * @param client_id 输出唯一客户端ID缓冲区，需在使用cfg期间有效
+ */
+static void build_client_config(const mqtt_config_t* mqtt, const timeout_config_t* timeouts,
+                                esp_mqtt_client_config_t* cfg,
+                                char* uri, size_t uri_size, char* client_id, size_t client_id_size) {
+    // 构建MQTT URI
+    snprintf(uri, uri_size, "mqtt://%s:%d", mqtt->broker_host, mqtt->broker_port);
+    
+    // 生成唯一的客户端ID（避免冲突）
+    uint8_t mac[6];
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    snprintf(client_id, client_id_size, "%s-%02x%02x%02x", mqtt->client_id, mac[3], mac[4], mac[5]);
+    
+    // 配置MQTT客户端（从配置文件读取超时参数）
+    *cfg = (esp_mqtt_client_config_t) {
+        .broker.address.uri = uri,
+        .credentials.client_id = client_id,
+        .session.keepalive = mqtt->keepalive,
+        .session.disable_clean_session = true,  // 使用clean session避免状态冲突
+        .network.reconnect_timeout_ms = timeouts->mqtt_reconnect_timeout,
+        .network.timeout_ms = timeouts->mqtt_connect_timeout,
+        .network.refresh_connection_after_ms = timeouts->mqtt_refresh_connection,
+        .session.protocol_ver = MQTT_PROTOCOL_V_3_1_1,  // 使用MQTT 3.1.1协议
+        .network.disable_auto_reconnect = false,
+        .session.last_will.topic = "xj1core/status",
+        .session.last_will.msg = "offline",
+        .session.last_will.msg_len = 7,
+        .session.last_will.qos = 0,
+        .session.last_will.retain = false,
+    };
+}
+
+/**
+ * @brief 改订一个主题
+ * @param keep 仍在使用、不能退订的另一个主题
+ * @note 先订阅新主题再退订旧主题，切换期间不漏收消息
+ */
+static void resubscribe_topic(const char* old_topic, const char* new_topic, const char* keep, int qos) {
+    if (strcmp(old_topic, new_topic) == 0) {
+        return;
+    }
+    
+    int msg_id = esp_mqtt_client_subscribe(g_mqtt_client, new_topic, qos);
+    if (old_topic[0] && strcmp(old_topic, keep) != 0) {
+        esp_mqtt_client_unsubscribe(g_mqtt_client, old_topic);
+    }
+    ESP_LOGI(TAG, "📥 已改订主题: %s -> %s, msg_id=%d", old_topic, new_topic, msg_id);
+}
+
+/**
+ * @brief 把新的MQTT和超时配置应用到运行中的客户端
+ * @note 服务器地址、端口或客户端ID变化时必须重连；保活时间增大时服务器仍按旧值判断超时，也需重连；
+ *       保活时间减小和超时参数只更新客户端参数；主题变化只改订变化的主题，不断开连接。
+ *       停止和重启客户端会阻塞，只在监控任务中调用
+ */
+static void apply_client_config(const mqtt_config_t* mqtt, const timeout_config_t* timeouts) {
+    bool reconnect = strcmp(mqtt->broker_host, g_applied_mqtt.broker_host) != 0 ||
+                     mqtt->broker_port != g_applied_mqtt.broker_port ||
+                     strcmp(mqtt->client_id, g_applied_mqtt.client_id) != 0 ||
+                     mqtt->keepalive > g_applied_mqtt.keepalive;
+    bool update = reconnect || mqtt->keepalive != g_applied_mqtt.keepalive ||
+                  memcmp(timeouts, &g_applied_timeouts, sizeof(timeout_config_t)) != 0;
+    
+    if (update) {
+        if (validate_mqtt_config(mqtt) != ESP_OK) {
+            ESP_LOGE(TAG, "新的MQTT配置无效，保持当前连接");
+            return;
+        }
+        
+        char uri[128];
+        char client_id[64];
+        esp_mqtt_client_config_t cfg;
+        build_client_config(mqtt, timeouts, &cfg, uri, sizeof(uri), client_id, sizeof(client_id));
+        
+        if (reconnect && g_mqtt_started) {
+            ESP_LOGI(TAG, "🔄 MQTT服务器或客户端参数变化，重连到 %s (客户端ID: %s)", uri, client_id);
+            g_reconnect_start_us = esp_timer_get_time();
+            esp_mqtt_client_stop(g_mqtt_client);
+            g_mqtt_connected = false;
+            esp_mqtt_set_config(g_mqtt_client, &cfg);
+            if (esp_mqtt_client_start(g_mqtt_client) != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to restart MQTT client");
+                g_mqtt_started = false;
+            }
+        } else {
+            esp_mqtt_set_config(g_mqtt_client, &cfg);
+            ESP_LOGI(TAG, "⏱️  MQTT保活/超时参数已更新，无需重连 (保活%d秒)", mqtt->keepalive);
+        }
+    }
+    
+    // 重连时由连接成功事件订阅新主题
+    if (!reconnect && g_mqtt_connected) {
+        resubscribe_topic(g_applied_mqtt.topic_teacher_to_student, mqtt->topic_teacher_to_student, mqtt->default_topic, 1);
+        resubscribe_topic(g_applied_mqtt.default_topic, mqtt->default_topic, mqtt->topic_teacher_to_student, 0);
+    }
+    
+    memcpy(&g_applied_mqtt, mqtt, sizeof(mqtt_config_t));
+    memcpy(&g_applied_timeouts, timeouts, sizeof(timeout_config_t));
+}
+
+/**
+ * @brief 在监控任务中应用配置变化回调缓存的新配置
+ */
+static void apply_pending_config(void) {
+    mqtt_config_t mqtt;
+    timeout_config_t timeouts;
+    
+    xSemaphoreTake(g_topic_mutex, portMAX_DELAY);
+    bool pending = g_config_pending;
+    if (pending) {
+        memcpy(&mqtt, &g_pending_mqtt, sizeof(mqtt_config_t));
+        memcpy(&timeouts, &g_pending_timeouts, sizeof(timeout_config_t));
+        g_config_pending = false;
+    }
+    xSemaphoreGive(g_topic_mutex);
+    
+    if (pending) {
+        apply_client_config(&mqtt, &timeouts);
+    }
+}
+
+/**
+ * @brief MQTT、超时和间隔配置变化回调
+ * @note 订阅时以当前配置调用一次，完成主题和间隔的初始加载；客户端初始化后的修改只缓存并通知监控任务，
+ *       由监控任务重连或改订主题，不阻塞写配置的任务
+ */
+static void on_config_changed(uint32_t sections, const system_config_t* config, void* arg) {
+    if (sections & CONFIG_SECTION_MQTT) {
+        const mqtt_config_t* mqtt = &config->mqtt;
+        
+        xSemaphoreTake(g_topic_mutex, portMAX_DELAY);
+        strlcpy(g_topic_student_to_teacher, mqtt->topic_student_to_teacher, sizeof(g_topic_student_to_teacher));
+        strlcpy(g_topic_teacher_to_student, mqtt->topic_teacher_to_student, sizeof(g_topic_teacher_to_student));
+        strlcpy(g_topic_student_heartbeat, mqtt->topic_student_heartbeat, sizeof(g_topic_student_heartbeat));
+        strlcpy(g_topic_student_status, mqtt->topic_student_status, sizeof(g_topic_student_status));
+        xSemaphoreGive(g_topic_mutex);
         
         ESP_LOGI(TAG, "MQTT topics loaded from config:");
-        ESP_LOGI(TAG, "  Student->Teacher: %s", g_topic_student_to_teacher);
-        ESP_LOGI(TAG, "  Teacher->Student: %s", g_topic_teacher_to_student);
-        ESP_LOGI(TAG, "  Heartbeat: %s", g_topic_student_heartbeat);
-        ESP_LOGI(TAG, "  Status: %s", g_topic_student_status);
-    } else {
-        ESP_LOGW(TAG, "Failed to load MQTT config, using default topics");
+        ESP_LOGI(TAG, "  Student->Teacher: %s", mqtt->topic_student_to_teacher);
+        ESP_LOGI(TAG, "  Teacher->Student: %s", mqtt->topic_teacher_to_student);
+        ESP_LOGI(TAG, "  Heartbeat: %s", mqtt->topic_student_heartbeat);
+        ESP_LOGI(TAG, "  Status: %s", mqtt->topic_student_status);
+    }
+    
+    if (g_mqtt_initialized && (sections & (CONFIG_SECTION_MQTT | CONFIG_SECTION_TIMEOUTS))) {
+        xSemaphoreTake(g_topic_mutex, portMAX_DELAY);
+        memcpy(&g_pending_mqtt, &config->mqtt, sizeof(mqtt_config_t));
+        memcpy(&g_pending_timeouts, &config->timeouts, sizeof(timeout_config_t));
+        g_config_pending = true;
+        xSemaphoreGive(g_topic_mutex);
+        
+        // 监控任务未启动时，由它启动后的第一轮循环应用
+        if (g_mqtt_monitor_task_handle) {
+            xTaskNotifyGive(g_mqtt_monitor_task_handle);
+        }
+    }
+    
+    if (sections & CONFIG_SECTION_INTERVALS) {
+        update_interval(&g_heartbeat_interval, config->intervals.heartbeat_interval, g_heartbeat_task_handle);
+        update_interval(&g_monitor_interval, config->intervals.monitor_check_interval, g_mqtt_monitor_task_handle);
     }
 }
 
@@ -74,10 +276,16 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             ESP_LOGI(TAG, "🎉 MQTT连接成功！师生通信链路已建立");
             ESP_LOGI(TAG, "⏰ 连接时间: %lld毫秒", esp_timer_get_time() / 1000);
             g_mqtt_connected = true;
+            if (g_reconnect_start_us) {
+                ESP_LOGI(TAG, "⏱️  配置修改引起的连接中断: %lld毫秒", (esp_timer_get_time() - g_reconnect_start_us) / 1000);
+                g_reconnect_start_us = 0;
+            }
             
             // 订阅老师的消息主题
-            int msg_id = esp_mqtt_client_subscribe(g_mqtt_client, g_topic_teacher_to_student, 1);
-            ESP_LOGI(TAG, "📥 已订阅老师消息主题: %s, msg_id=%d", g_topic_teacher_to_student, msg_id);
+            char teacher_topic[64];
+            copy_topic(teacher_topic, g_topic_teacher_to_student);
+            int msg_id = esp_mqtt_client_subscribe(g_mqtt_client, teacher_topic, 1);
+            ESP_LOGI(TAG, "📥 已订阅老师消息主题: %s, msg_id=%d", teacher_topic, msg_id);
             
             // 自动订阅默认主题
             mqtt_config_t mqtt_config;
@@ -128,7 +336,9 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             ESP_LOGI(TAG, "💬 内容: %s", data);
             
             // 特殊处理老师的消息
-            if (strstr(topic, "teacher") != NULL || strstr(topic, g_topic_teacher_to_student) != NULL) {
+            char teacher_topic_now[64];
+            copy_topic(teacher_topic_now, g_topic_teacher_to_student);
+            if (strstr(topic, "teacher") != NULL || strstr(topic, teacher_topic_now) != NULL) {
                 ESP_LOGI(TAG, "💖 收到老师的消息！");
                 ESP_LOGI(TAG, "🎓 老师说: %s", data);
                 
@@ -171,29 +381,33 @@ esp_err_t mqtt_client_init(void) {
         return ESP_OK;
     }
     
-    // 从配置文件加载MQTT主题
-    load_mqtt_topics_from_config();
+    // 订阅MQTT和间隔配置，订阅时回调一次加载主题和间隔，之后修改立即生效
+    esp_err_t ret;
+    if (!g_topic_mutex) {
+        g_topic_mutex = xSemaphoreCreateMutex();
+        if (!g_topic_mutex) {
+            ESP_LOGE(TAG, "Failed to create topic mutex");
+            return ESP_ERR_NO_MEM;
+        }
+        ret = config_manager_subscribe(CONFIG_SECTION_MQTT | CONFIG_SECTION_TIMEOUTS | CONFIG_SECTION_INTERVALS,
+                                       on_config_changed, NULL);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to subscribe MQTT config, using default topics");
+        }
+    }
     
     // 获取MQTT配置
     mqtt_config_t mqtt_config;
-    esp_err_t ret = config_manager_get_mqtt(&mqtt_config);
+    ret = config_manager_get_mqtt(&mqtt_config);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to get MQTT config");
         return ret;
     }
     
     // 验证配置完整性
-    if (strlen(mqtt_config.broker_host) == 0) {
-        ESP_LOGE(TAG, "MQTT broker_host为空，请检查config.ini配置");
-        return ESP_ERR_INVALID_ARG;
-    }
-    if (mqtt_config.broker_port <= 0 || mqtt_config.broker_port > 65535) {
-        ESP_LOGE(TAG, "MQTT broker_port无效: %d，请检查config.ini配置", mqtt_config.broker_port);
-        return ESP_ERR_INVALID_ARG;
-    }
-    if (strlen(mqtt_config.client_id) == 0) {
-        ESP_LOGE(TAG, "MQTT client_id为空，请检查config.ini配置");
-        return ESP_ERR_INVALID_ARG;
+    ret = validate_mqtt_config(&mqtt_config);
+    if (ret != ESP_OK) {
+        return ret;
     }
     
     ESP_LOGI(TAG, "🔧 MQTT配置验证通过:");
@@ -201,21 +415,6 @@ esp_err_t mqtt_client_init(void) {
     ESP_LOGI(TAG, "  客户端ID: %s", mqtt_config.client_id);
     ESP_LOGI(TAG, "  保活时间: %d秒", mqtt_config.keepalive);
     
-    // 构建MQTT URI
-    char mqtt_uri[128];
-    snprintf(mqtt_uri, sizeof(mqtt_uri), "mqtt://%s:%d", mqtt_config.broker_host, mqtt_config.broker_port);
-    
-    // 生成唯一的客户端ID（避免冲突）
-    char unique_client_id[64];
-    uint8_t mac[6];
-    esp_read_mac(mac, ESP_MAC_WIFI_STA);
-    snprintf(unique_client_id, sizeof(unique_client_id), "%s-%02x%02x%02x", 
-             mqtt_config.client_id, mac[3], mac[4], mac[5]);
-    
-    ESP_LOGI(TAG, "🆔 使用唯一客户端ID: %s", unique_client_id);
-    ESP_LOGI(TAG, "🔗 MQTT URI: %s", mqtt_uri);
-    ESP_LOGI(TAG, "⏱️  保活时间: %d秒", mqtt_config.keepalive);
-    
     // 获取超时配置
     timeout_config_t timeout_config;
     esp_err_t timeout_ret = config_manager_get_timeouts(&timeout_config);
@@ -226,23 +425,15 @@ esp_err_t mqtt_client_init(void) {
         timeout_config.mqtt_refresh_connection = 30000;
     }
     
-    // 配置MQTT客户端（从配置文件读取超时参数）
-    esp_mqtt_client_config_t mqtt_cfg = {
-        .broker.address.uri = mqtt_uri,
-        .credentials.client_id = unique_client_id,
-        .session.keepalive = mqtt_config.keepalive,
-        .session.disable_clean_session = true,  // 使用clean session避免状态冲突
-        .network.reconnect_timeout_ms = timeout_config.mqtt_reconnect_timeout,
-        .network.timeout_ms = timeout_config.mqtt_connect_timeout,
-        .network.refresh_connection_after_ms = timeout_config.mqtt_refresh_connection,
-        .session.protocol_ver = MQTT_PROTOCOL_V_3_1_1,  // 使用MQTT 3.1.1协议
-        .network.disable_auto_reconnect = false,
-        .session.last_will.topic = "xj1core/status",
-        .session.last_will.msg = "offline",
-        .session.last_will.msg_len = 7,
-        .session.last_will.qos = 0,
-        .session.last_will.retain = false,
-    };
+    char mqtt_uri[128];
+    char unique_client_id[64];
+    esp_mqtt_client_config_t mqtt_cfg;
+    build_client_config(&mqtt_config, &timeout_config, &mqtt_cfg,
+                        mqtt_uri, sizeof(mqtt_uri), unique_client_id, sizeof(unique_client_id));
+    
+    ESP_LOGI(TAG, "🆔 使用唯一客户端ID: %s", unique_client_id);
+    ESP_LOGI(TAG, "🔗 MQTT URI: %s", mqtt_uri);
+    ESP_LOGI(TAG, "⏱️  保活时间: %d秒", mqtt_config.keepalive);
     
     g_mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
     if (!g_mqtt_client) {
@@ -259,6 +450,8 @@ esp_err_t mqtt_client_init(void) {
         return ret;
     }
     
+    memcpy(&g_applied_mqtt, &mqtt_config, sizeof(mqtt_config_t));
+    memcpy(&g_applied_timeouts, &timeout_config, sizeof(timeout_config_t));
     g_mqtt_initialized = true;
     ESP_LOGI(TAG, "MQTT client initialized successfully");
     ESP_LOGI(TAG, "Broker: %s:%d, Client ID: %s", mqtt_config.broker_host, mqtt_config.broker_port, mqtt_config.client_id);
@@ -324,6 +517,7 @@ esp_err_t mqtt_client_start(void) {
         return ret;
     }
     
+    g_mqtt_started = true;
     ESP_LOGI(TAG, "MQTT client started, waiting for connection...");
     return ESP_OK;
 }
@@ -339,6 +533,7 @@ esp_err_t mqtt_client_stop(void) {
         return ret;
     }
     
+    g_mqtt_started = false;
     g_mqtt_connected = false;
     ESP_LOGI(TAG, "MQTT client stopped");
     return ESP_OK;
@@ -453,7 +648,9 @@ esp_err_t mqtt_client_send_student_message(const char* message) {
     
     ESP_LOGI(TAG, "💌 向老师发送消息: %s", message);
     
-    esp_err_t ret = mqtt_client_publish(g_topic_student_to_teacher, json_string, strlen(json_string));
+    char topic[64];
+    copy_topic(topic, g_topic_student_to_teacher);
+    esp_err_t ret = mqtt_client_publish(topic, json_string, strlen(json_string));
     
     free(json_string);
     cJSON_Delete(json);
@@ -486,7 +683,9 @@ esp_err_t mqtt_client_send_heartbeat(void) {
     
     char *json_string = cJSON_Print(json);
     
-    esp_err_t ret = mqtt_client_publish(g_topic_student_heartbeat, json_string, strlen(json_string));
+    char topic[64];
+    copy_topic(topic, g_topic_student_heartbeat);
+    esp_err_t ret = mqtt_client_publish(topic, json_string, strlen(json_string));
     
     free(json_string);
     cJSON_Delete(json);
@@ -509,7 +708,9 @@ esp_err_t mqtt_client_publish_status(const char* status, const char* message) {
     cJSON_AddNumberToObject(json, "timestamp", esp_timer_get_time() / 1000000);
     
     char *json_string = cJSON_Print(json);
-    esp_err_t ret = mqtt_client_publish(g_topic_student_status, json_string, strlen(json_string));
+    char topic[64];
+    copy_topic(topic, g_topic_student_status);
+    esp_err_t ret = mqtt_client_publish(topic, json_string, strlen(json_string));
     
     free(json_string);
     cJSON_Delete(json);
@@ -557,14 +758,8 @@ static void student_heartbeat_task(void *pvParameters) {
             ESP_LOGW(TAG, "MQTT连接断开，暂停发送思念消息");
         }
         
-        // 获取心跳间隔配置
-        interval_config_t interval_config;
-        int heartbeat_interval = 5000; // 默认值
-        if (config_manager_get_intervals(&interval_config) == ESP_OK) {
-            heartbeat_interval = interval_config.heartbeat_interval;
-        }
-        
-        vTaskDelay(pdMS_TO_TICKS(heartbeat_interval));
+        // 等待下一个周期，间隔修改时提前唤醒
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(g_heartbeat_interval));
     }
 }
 
@@ -605,6 +800,9 @@ static void mqtt_monitor_task(void *pvParameters) {
     ESP_LOGI(TAG, "🔍 MQTT连接监控任务启动");
     
     while (1) {
+        // 应用配置变化回调缓存的MQTT和超时配置
+        apply_pending_config();
+        
         if (!g_mqtt_connected && g_mqtt_initialized) {
             connection_attempts++;
             int current_time = esp_timer_get_time() / 1000000;
@@ -651,14 +849,8 @@ static void mqtt_monitor_task(void *pvParameters) {
             }
         }
         
-        // 获取监控检查间隔配置
-        interval_config_t interval_config;
-        int monitor_interval = 10000; // 默认值
-        if (config_manager_get_intervals(&interval_config) == ESP_OK) {
-            monitor_interval = interval_config.monitor_check_interval;
-        }
-        
-        vTaskDelay(pdMS_TO_TICKS(monitor_interval));
+        // 等待下一个周期，间隔或MQTT配置修改时提前唤醒
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(g_monitor_interval));
     }
 }
 
@@ -674,7 +866,7 @@ esp_err_t mqtt_client_start_monitor(void) {
     BaseType_t ret = xTaskCreate(
         mqtt_monitor_task,
         "mqtt_monitor",
-        4096,
+        6144,  // 需容纳应用新配置时的MQTT客户端参数和配置副本
         NULL,
         3,
         &g_mqtt_monitor_task_handle
@@ -24,92 +24,122 @@
 #include "bluetooth_manager.h"
 #include "ethernet_manager.h"
 #include "mqtt_manager.h"
+#include "web_assets.h"
 #include "esp_log.h"
 #include "esp_http_server.h"
 #include "esp_timer.h"
 #include "cJSON.h"
+#include "esp_rom_crc.h"
+#include "lwip/sockets.h"
 #include <string.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+#define CONFIG_API_MAX_BODY 2048       // POST /api/config请求体上限，足够容纳全部配置段
 
 static const char *TAG = "web_server";
 static httpd_handle_t g_server = NULL;
 static network_status_t g_network_status = {0};
 
+/**
+ * @brief GET /api/config的响应缓存，配置代数变化后第一次请求时重建
+ * @note 只在httpd任务中访问，不需要加锁
+ */
+static struct {
+    bool valid;
+    uint32_t generation;
+    char etag[24];                      // "代数-响应体CRC32"，CRC保证重启后代数重复时不会误判
+    char* body;
+} g_config_response;
+
 // 外部引用的HTML页面内容
-extern const char login_html_start[] asm("_binary_login_html_start");
-extern const char login_html_end[] asm("_binary_login_html_end");
-extern const char index_html_start[] asm("_binary_index_html_start");
-extern const char index_html_end[] asm("_binary_index_html_end");
+// 构建时gzip压缩的网页，ETag由main/embed_web_assets.py生成
+extern const char login_html_gz_start[] asm("_binary_login_html_gz_start");
+extern const char login_html_gz_end[] asm("_binary_login_html_gz_end");
+extern const char index_html_gz_start[] asm("_binary_index_html_gz_start");
+extern const char index_html_gz_end[] asm("_binary_index_html_gz_end");
 
 /**
- * @brief 从请求头获取会话ID
+ * @brief 从Cookie请求头获取会话ID
+ * @note 请求头读入栈上缓冲区，不分配堆内存；httpd不接受超过CONFIG_HTTPD_MAX_REQ_HDR_LEN的请求头，
+ *       所以缓冲区不会截断
  */
 static esp_err_t get_session_id_from_header(httpd_req_t *req, char* session_id) {
-    size_t buf_len = httpd_req_get_hdr_value_len(req, "Cookie");
-    if (buf_len == 0) {
-        return ESP_ERR_NOT_FOUND;
-    }
-    
-    char* buf = malloc(buf_len + 1);
-    if (!buf) {
-        return ESP_ERR_NO_MEM;
-    }
-    
-    if (httpd_req_get_hdr_value_str(req, "Cookie", buf, buf_len + 1) != ESP_OK) {
-        free(buf);
+    char header[CONFIG_HTTPD_MAX_REQ_HDR_LEN];
+    if (httpd_req_get_hdr_value_str(req, "Cookie", header, sizeof(header)) != ESP_OK) {
         return ESP_ERR_NOT_FOUND;
     }
-    
-    // 查找session_id cookie
-    char* session_start = strstr(buf, "session_id=");
-    if (!session_start) {
-        free(buf);
+    return auth_parse_cookie(header, session_id);
+}
+
+/**
+ * @brief 从Authorization: Bearer请求头获取API密钥或令牌
+ */
+static esp_err_t get_bearer_from_header(httpd_req_t *req, char* credential) {
+    char header[CONFIG_HTTPD_MAX_REQ_HDR_LEN];
+    if (httpd_req_get_hdr_value_str(req, "Authorization", header, sizeof(header)) != ESP_OK) {
         return ESP_ERR_NOT_FOUND;
     }
+    return auth_parse_bearer(header, credential);
+}
+
+/**
+ * @brief 检查用户是否已认证，Bearer凭据优先于会话cookie
+ */
+static bool is_authenticated(httpd_req_t *req) {
+    char credential[AUTH_CREDENTIAL_MAX_LENGTH + 1];
     
-    session_start += strlen("session_id=");
-    char* session_end = strchr(session_start, ';');
-    
-    int session_len = session_end ? (session_end - session_start) : strlen(session_start);
-    if (session_len > AUTH_SESSION_ID_LENGTH) {
-        session_len = AUTH_SESSION_ID_LENGTH;
+    if (get_bearer_from_header(req, credential) != ESP_OK &&
+        get_session_id_from_header(req, credential) != ESP_OK) {
+        return false;
     }
     
-    strncpy(session_id, session_start, session_len);
-    session_id[session_len] = '\0';
-    
-    free(buf);
-    return ESP_OK;
+    return auth_validate_session(credential);
 }
 
 /**
- * @brief 检查用户是否已认证
+ * @brief 检查请求是否来自登录后的会话
+ * @note API密钥只能由登录后的会话管理，泄露的密钥不能用来创建新密钥
  */
-static bool is_authenticated(httpd_req_t *req) {
-    char session_id[AUTH_SESSION_ID_LENGTH + 1];
+static bool is_session_authenticated(httpd_req_t *req) {
+    char session_id[AUTH_CREDENTIAL_MAX_LENGTH + 1];
     
-    if (get_session_id_from_header(req, session_id) != ESP_OK) {
+    if (get_session_id_from_header(req, session_id) != ESP_OK || auth_is_api_key(session_id)) {
         return false;
     }
     
     return auth_validate_session(session_id);
 }
 
+/**
+ * @brief 获取HTTP状态行
+ */
+static const char* http_status_line(int status_code) {
+    switch (status_code) {
+        case 200: return "200 OK";
+        case 304: return "304 Not Modified";
+        case 400: return "400 Bad Request";
+        case 401: return "401 Unauthorized";
+        case 404: return "404 Not Found";
+        case 429: return "429 Too Many Requests";
+        default:  return "500 Internal Server Error";
+    }
+}
+
 /**
  * @brief 发送JSON响应
+ * @param json_str 响应体，为NULL时不发送响应体（如304）
  */
 static esp_err_t send_json_response(httpd_req_t *req, int status_code, const char* json_str) {
-    if (status_code == 200) {
-        httpd_resp_set_status(req, "200 OK");
-    } else if (status_code == 401) {
-        httpd_resp_set_status(req, "401 Unauthorized");
-    } else {
-        httpd_resp_set_status(req, "500 Internal Server Error");
-    }
+    httpd_resp_set_status(req, http_status_line(status_code));
     httpd_resp_set_type(req, "application/json");
     httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
     httpd_resp_set_hdr(req, "Access-Control-Allow-Methods", "GET, POST, OPTIONS");
     httpd_resp_set_hdr(req, "Access-Control-Allow-Headers", "Content-Type, Authorization");
     
+    if (!json_str) {
+        return httpd_resp_send(req, NULL, 0);
+    }
     return httpd_resp_send(req, json_str, HTTPD_RESP_USE_STRLEN);
 }
 
@@ -129,21 +159,48 @@ static esp_err_t root_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
+/**
+ * @brief 检查请求的If-None-Match是否包含当前ETag
+ */
+static bool etag_matches(httpd_req_t *req, const char* etag) {
+    char value[96];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", value, sizeof(value)) != ESP_OK) {
+        return false;
+    }
+    // 可能是逗号分隔的多个ETag或带W/前缀的弱ETag，包含即视为匹配
+    return strcmp(value, "*") == 0 || strstr(value, etag) != NULL;
+}
+
+/**
+ * @brief 发送构建时压缩的网页，If-None-Match与ETag相同时只返回304
+ * @note 只嵌入压缩后的内容，所有浏览器都支持gzip，不再按Accept-Encoding区分
+ */
+static esp_err_t send_web_asset(httpd_req_t *req, const char* start, const char* end,
+                                const char* etag, const char* cache_control) {
+    httpd_resp_set_type(req, "text/html; charset=utf-8");
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", cache_control);
+    
+    if (etag_matches(req, etag)) {
+        httpd_resp_set_status(req, http_status_line(304));
+        return httpd_resp_send(req, NULL, 0);
+    }
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, start, end - start);
+}
+
 /**
  * @brief 登录页面处理器
+ * @note 登录页不含用户数据，缓存一天；地址没有版本号，固件升级后最迟一天内更新
  */
 static esp_err_t login_page_handler(httpd_req_t *req) {
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_set_hdr(req, "Content-Encoding", "utf-8");
-    
-    const size_t login_html_size = (login_html_end - login_html_start);
-    httpd_resp_send(req, login_html_start, login_html_size);
-    
-    return ESP_OK;
+    return send_web_asset(req, login_html_gz_start, login_html_gz_end,
+                          WEB_ASSET_LOGIN_HTML_ETAG, "public, max-age=86400");
 }
 
 /**
  * @brief 主页面处理器
+ * @note 每次打开都要经过认证检查，浏览器保留副本但必须先向设备确认，内容未变时只返回304
  */
 static esp_err_t index_page_handler(httpd_req_t *req) {
     if (!is_authenticated(req)) {
@@ -153,12 +210,32 @@ static esp_err_t index_page_handler(httpd_req_t *req) {
         return ESP_OK;
     }
     
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_set_hdr(req, "Content-Encoding", "utf-8");
-    
-    const size_t index_html_size = (index_html_end - index_html_start);
-    httpd_resp_send(req, index_html_start, index_html_size);
-    
+    return send_web_asset(req, index_html_gz_start, index_html_gz_end,
+                          WEB_ASSET_INDEX_HTML_ETAG, "private, no-cache");
+}
+
+/**
+ * @brief 获取客户端地址，IPv4地址转换为IPv4映射的IPv6地址
+ */
+static esp_err_t get_client_address(httpd_req_t *req, uint8_t* client) {
+    memset(client, 0, AUTH_CLIENT_ADDR_BYTES);
+    
+    struct sockaddr_storage addr;
+    socklen_t addr_len = sizeof(addr);
+    int sockfd = httpd_req_to_sockfd(req);
+    if (sockfd < 0 || getpeername(sockfd, (struct sockaddr*)&addr, &addr_len) != 0) {
+        return ESP_FAIL;
+    }
+    
+    if (addr.ss_family == AF_INET6) {
+        memcpy(client, &((struct sockaddr_in6*)&addr)->sin6_addr, AUTH_CLIENT_ADDR_BYTES);
+    } else if (addr.ss_family == AF_INET) {
+        client[10] = 0xff;
+        client[11] = 0xff;
+        memcpy(&client[12], &((struct sockaddr_in*)&addr)->sin_addr, 4);
+    } else {
+        return ESP_FAIL;
+    }
     return ESP_OK;
 }
 
@@ -166,6 +243,19 @@ static esp_err_t index_page_handler(httpd_req_t *req) {
  * @brief 登录API处理器
  */
 static esp_err_t login_api_handler(httpd_req_t *req) {
+    // 先按客户端限速，被拒绝的请求不读取请求体、不解析JSON、不计算哈希；
+    // 取不到地址时所有这类请求共用全零地址的记录
+    uint8_t client[AUTH_CLIENT_ADDR_BYTES];
+    get_client_address(req, client);
+    uint32_t retry_after_ms = 0;
+    if (!auth_login_throttle_allow(client, &retry_after_ms)) {
+        char retry_after[12];
+        snprintf(retry_after, sizeof(retry_after), "%" PRIu32, (retry_after_ms + 999) / 1000);
+        httpd_resp_set_hdr(req, "Retry-After", retry_after);
+        send_json_response(req, 429, "{\"success\":false,\"message\":\"登录尝试过于频繁，请稍后再试\"}");
+        return ESP_OK;
+    }
+    
     char content[256];
     int ret = httpd_req_recv(req, content, sizeof(content) - 1);
     if (ret <= 0) {
@@ -190,62 +280,38 @@ static esp_err_t login_api_handler(httpd_req_t *req) {
         return ESP_OK;
     }
     
+    if (!cJSON_IsString(username_json) || !cJSON_IsString(password_json)) {
+        cJSON_Delete(json);
+        send_json_response(req, 400, "{\"success\":false,\"message\":\"用户名和密码必须是字符串\"}");
+        return ESP_OK;
+    }
+    
     const char* username = cJSON_GetStringValue(username_json);
     const char* password = cJSON_GetStringValue(password_json);
     
-    // 添加调试信息
-    auth_config_t auth_config;
-    config_manager_get_auth(&auth_config);
-    char test_hash[65];
-    auth_calculate_sha256(password, test_hash);
-    
-    // 验证登录
-    char session_id[AUTH_SESSION_ID_LENGTH + 1];
+    // 验证登录，密码只在auth_login中计算一次哈希
+    char session_id[AUTH_CREDENTIAL_MAX_LENGTH + 1];
     esp_err_t auth_result = auth_login(username, password, session_id);
-    
-    cJSON_Delete(json);
+    if (auth_result == ESP_OK || auth_result == ESP_ERR_INVALID_ARG) {
+        auth_login_throttle_record(client, auth_result == ESP_OK);
+    }
     
     if (auth_result == ESP_OK) {
-        // 获取会话超时配置
-        timeout_config_t timeout_config;
-        int session_max_age = 1800; // 默认30分钟
-        if (config_manager_get_timeouts(&timeout_config) == ESP_OK) {
-            session_max_age = timeout_config.session_max_age;
-        }
-        
-        // 设置cookie并返回成功响应
+        // cookie有效期与服务端会话超时一致
         char cookie_header[128];
         snprintf(cookie_header, sizeof(cookie_header), 
-                "session_id=%s; Path=/; Max-Age=%d", session_id, session_max_age);
+                "session_id=%s; Path=/; Max-Age=%" PRIu32, session_id, auth_get_session_timeout_ms() / 1000);
         httpd_resp_set_hdr(req, "Set-Cookie", cookie_header);
         
         send_json_response(req, 200, "{\"success\":true,\"message\":\"登录成功\"}");
         ESP_LOGI(TAG, "User %s logged in successfully", username);
     } else {
-        // 使用cJSON构建安全的JSON响应
-        cJSON *response = cJSON_CreateObject();
-        cJSON *debug = cJSON_CreateObject();
-        
-        cJSON_AddBoolToObject(response, "success", false);
-        cJSON_AddStringToObject(response, "message", "用户名或密码错误");
-        
-        cJSON_AddStringToObject(debug, "input_username", username ? username : "null");
-        cJSON_AddStringToObject(debug, "input_password", password ? "***" : "null"); // 隐藏密码
-        cJSON_AddStringToObject(debug, "config_username", auth_config.username);
-        cJSON_AddStringToObject(debug, "config_hash", auth_config.password_hash);
-        cJSON_AddStringToObject(debug, "calculated_hash", test_hash);
-        cJSON_AddBoolToObject(debug, "hash_match", strcmp(test_hash, auth_config.password_hash) == 0);
-        
-        cJSON_AddItemToObject(response, "debug", debug);
-        
-        char *json_string = cJSON_Print(response);
-        send_json_response(req, 401, json_string);
-        
-        free(json_string);
-        cJSON_Delete(response);
+        send_json_response(req, 401, "{\"success\":false,\"message\":\"用户名或密码错误\"}");
         ESP_LOGW(TAG, "Login failed for user %s", username);
     }
     
+    // username指向JSON内部，记录日志后再释放
+    cJSON_Delete(json);
     return ESP_OK;
 }
 
@@ -253,7 +319,7 @@ static esp_err_t login_api_handler(httpd_req_t *req) {
  * @brief 登出API处理器
  */
 static esp_err_t logout_api_handler(httpd_req_t *req) {
-    char session_id[AUTH_SESSION_ID_LENGTH + 1];
+    char session_id[AUTH_CREDENTIAL_MAX_LENGTH + 1];
     
     if (get_session_id_from_header(req, session_id) == ESP_OK) {
         auth_logout(session_id);
@@ -266,6 +332,46 @@ static esp_err_t logout_api_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
+/**
+ * @brief 配置代数变化时重建GET /api/config的响应体和ETag
+ * @return ESP_OK缓存可用，其他值失败
+ */
+static esp_err_t refresh_config_response(void) {
+    if (g_config_response.valid && g_config_response.generation == config_manager_get_generation()) {
+        return ESP_OK;
+    }
+    
+    // 直接读取配置快照，不在httpd任务栈上复制整个配置结构体
+    uint32_t generation;
+    const system_config_t *config = config_manager_acquire(&generation);
+    if (!config) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // 构建JSON响应，字段由配置表生成
+    cJSON *json = cJSON_CreateObject();
+    config_manager_to_json(config, json);
+    config_manager_release(config);
+    
+    cJSON_AddBoolToObject(json, "success", true);
+    char *body = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+    if (!body) {
+        return ESP_ERR_NO_MEM;
+    }
+    size_t len = strlen(body);
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)body, len);
+    
+    free(g_config_response.body);
+    g_config_response.body = body;
+    g_config_response.generation = generation;
+    snprintf(g_config_response.etag, sizeof(g_config_response.etag), "\"%" PRIu32 "-%08" PRIx32 "\"",
+             generation, crc);
+    g_config_response.valid = true;
+    ESP_LOGD(TAG, "Config response rebuilt for generation %" PRIu32 " (%d bytes)", generation, (int)len);
+    return ESP_OK;
+}
+
 /**
  * @brief 获取配置API处理器
  */
@@ -275,61 +381,19 @@ static esp_err_t get_config_api_handler(httpd_req_t *req) {
         return ESP_OK;
     }
     
-    system_config_t config;
-    esp_err_t ret = config_manager_load(&config);
-    if (ret != ESP_OK) {
+    if (refresh_config_response() != ESP_OK) {
         send_json_response(req, 500, "{\"success\":false,\"message\":\"读取配置失败\"}");
         return ESP_OK;
     }
     
-    // 构建JSON响应
-    cJSON *json = cJSON_CreateObject();
-    cJSON *wifi_ap = cJSON_CreateObject();
-    cJSON *wifi_sta = cJSON_CreateObject();
-    cJSON *ethernet = cJSON_CreateObject();
-    cJSON *bluetooth = cJSON_CreateObject();
-    cJSON *mqtt = cJSON_CreateObject();
-    
-    // WiFi AP配置
-    cJSON_AddStringToObject(wifi_ap, "ssid", config.wifi_ap.ssid);
-    cJSON_AddStringToObject(wifi_ap, "ip", config.wifi_ap.ip);
-    cJSON_AddStringToObject(wifi_ap, "password", config.wifi_ap.password);
-    cJSON_AddItemToObject(json, "wifi_ap", wifi_ap);
-    
-    // WiFi STA配置
-    cJSON_AddStringToObject(wifi_sta, "ssid", config.wifi_sta.ssid);
-    cJSON_AddStringToObject(wifi_sta, "password", config.wifi_sta.password);
-    cJSON_AddItemToObject(json, "wifi_sta", wifi_sta);
-    
-    // 以太网配置
-    cJSON_AddStringToObject(ethernet, "ip", config.ethernet.ip);
-    cJSON_AddStringToObject(ethernet, "netmask", config.ethernet.netmask);
-    cJSON_AddStringToObject(ethernet, "dns", config.ethernet.dns);
-    cJSON_AddStringToObject(ethernet, "gateway", config.ethernet.gateway);
-    cJSON_AddItemToObject(json, "ethernet", ethernet);
-    
-    // 蓝牙配置
-    cJSON_AddStringToObject(bluetooth, "device_name", config.bluetooth.device_name);
-    cJSON_AddStringToObject(bluetooth, "pairing_password", config.bluetooth.pairing_password);
-    cJSON_AddItemToObject(json, "bluetooth", bluetooth);
-    
-    // MQTT配置
-    cJSON_AddStringToObject(mqtt, "broker_host", config.mqtt.broker_host);
-    cJSON_AddNumberToObject(mqtt, "broker_port", config.mqtt.broker_port);
-    cJSON_AddStringToObject(mqtt, "client_id", config.mqtt.client_id);
-    cJSON_AddStringToObject(mqtt, "default_topic", config.mqtt.default_topic);
-    cJSON_AddNumberToObject(mqtt, "keepalive", config.mqtt.keepalive);
-    cJSON_AddItemToObject(json, "mqtt", mqtt);
-    
-    cJSON_AddBoolToObject(json, "success", true);
-    
-    char *json_string = cJSON_Print(json);
-    send_json_response(req, 200, json_string);
-    
-    free(json_string);
-    cJSON_Delete(json);
+    // 认证后的内容只允许浏览器自己缓存，每次使用前用ETag向设备确认
+    httpd_resp_set_hdr(req, "ETag", g_config_response.etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "private, no-cache");
     
-    return ESP_OK;
+    if (etag_matches(req, g_config_response.etag)) {
+        return send_json_response(req, 304, NULL);
+    }
+    return send_json_response(req, 200, g_config_response.body);
 }
 
 /**
@@ -1055,6 +1119,19 @@ static esp_err_t save_wifi_config_api_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
+/**
+ * @brief 检查点分十进制IPv4地址格式，空字符串视为未配置
+ */
+static bool is_valid_ipv4(const char* ip) {
+    if (strlen(ip) == 0) {
+        return true;
+    }
+    int a, b, c, d;
+    char tail;
+    return sscanf(ip, "%d.%d.%d.%d%c", &a, &b, &c, &d, &tail) == 4 &&
+           a >= 0 && a <= 255 && b >= 0 && b <= 255 && c >= 0 && c <= 255 && d >= 0 && d <= 255;
+}
+
 /**
  * @brief 以太网配置保存API处理器
  */
@@ -1103,17 +1180,7 @@ static esp_err_t save_ethernet_config_api_handler(httpd_req_t *req) {
              eth_config.ip, eth_config.gateway, eth_config.netmask, eth_config.dns);
     
     // 检查IP配置是否有效
-    bool config_valid = true;
-    if (strlen(eth_config.ip) > 0) {
-        // 简单的IP地址格式验证
-        int a, b, c, d;
-        if (sscanf(eth_config.ip, "%d.%d.%d.%d", &a, &b, &c, &d) != 4 ||
-            a < 0 || a > 255 || b < 0 || b > 255 || c < 0 || c > 255 || d < 0 || d > 255) {
-            config_valid = false;
-        }
-    }
-    
-    if (!config_valid) {
+    if (!is_valid_ipv4(eth_config.ip)) {
         cJSON_Delete(json);
         send_json_response(req, 400, "{\"success\":false,\"message\":\"以太网IP地址格式无效\"}");
         return ESP_OK;
@@ -1243,7 +1310,13 @@ static esp_err_t save_mqtt_config_api_handler(httpd_req_t *req) {
         return ESP_OK;
     }
     
-    mqtt_config_t mqtt_config = {0};
+    // 以当前配置为基础，只覆盖请求中提供的字段，避免未提交的主题被清空
+    mqtt_config_t mqtt_config;
+    if (config_manager_get_mqtt(&mqtt_config) != ESP_OK) {
+        cJSON_Delete(json);
+        send_json_response(req, 500, "{\"success\":false,\"message\":\"读取MQTT配置失败\"}");
+        return ESP_OK;
+    }
     
     cJSON *broker_host = cJSON_GetObjectItem(json, "broker_host");
     cJSON *broker_port = cJSON_GetObjectItem(json, "broker_port");
@@ -1267,10 +1340,195 @@ static esp_err_t save_mqtt_config_api_handler(httpd_req_t *req) {
         mqtt_config.keepalive = cJSON_GetNumberValue(keepalive);
     }
     
+    // 师生通信主题
+    static const struct {
+        const char* name;
+        size_t offset;
+    } topic_fields[] = {
+        {"topic_student_to_teacher", offsetof(mqtt_config_t, topic_student_to_teacher)},
+        {"topic_teacher_to_student", offsetof(mqtt_config_t, topic_teacher_to_student)},
+        {"topic_student_heartbeat", offsetof(mqtt_config_t, topic_student_heartbeat)},
+        {"topic_student_status", offsetof(mqtt_config_t, topic_student_status)},
+    };
+    for (size_t i = 0; i < sizeof(topic_fields) / sizeof(topic_fields[0]); i++) {
+        cJSON *topic = cJSON_GetObjectItem(json, topic_fields[i].name);
+        if (topic && cJSON_IsString(topic) && strlen(cJSON_GetStringValue(topic)) > 0) {
+            strlcpy((char*)&mqtt_config + topic_fields[i].offset, cJSON_GetStringValue(topic),
+                    sizeof(mqtt_config.topic_student_to_teacher));
+        }
+    }
+    
+    // 运行中的MQTT客户端通过配置订阅立即应用新配置，不需要重启
     config_manager_set_mqtt(&mqtt_config);
     
     cJSON_Delete(json);
-    send_json_response(req, 200, "{\"success\":true,\"message\":\"MQTT配置保存成功\"}");
+    send_json_response(req, 200, "{\"success\":true,\"message\":\"MQTT配置已保存并生效\"}");
+    return ESP_OK;
+}
+
+/**
+ * @brief 发送带错误描述的失败响应
+ */
+static esp_err_t send_error_response(httpd_req_t *req, int status_code, const char* message) {
+    cJSON *response = cJSON_CreateObject();
+    cJSON_AddBoolToObject(response, "success", false);
+    cJSON_AddStringToObject(response, "message", message);
+    char *json_string = cJSON_PrintUnformatted(response);
+    cJSON_Delete(response);
+    
+    esp_err_t ret = send_json_response(req, status_code, json_string ? json_string : "{\"success\":false}");
+    free(json_string);
+    return ret;
+}
+
+/**
+ * @brief 接收完整的请求体
+ * @return 以'\0'结尾的请求体，调用者负责释放；为空、超过max_len或接收失败返回NULL
+ */
+static char* receive_body(httpd_req_t *req, size_t max_len) {
+    if (req->content_len == 0 || req->content_len > max_len) {
+        return NULL;
+    }
+    
+    char *body = malloc(req->content_len + 1);
+    if (!body) {
+        return NULL;
+    }
+    
+    size_t received = 0;
+    while (received < req->content_len) {
+        int ret = httpd_req_recv(req, body + received, req->content_len - received);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (ret <= 0) {
+            free(body);
+            return NULL;
+        }
+        received += ret;
+    }
+    body[received] = '\0';
+    return body;
+}
+
+/**
+ * @brief 配置事务API处理器
+ * @note 请求体格式与GET /api/config相同，可以只包含任意几个配置段和字段。全部字段校验通过后
+ *       才作为一个配置快照发布并立即写入一次文件，任何一项无效则整个请求不生效。
+ *       发布后新配置已经生效并通知了订阅者，写入flash失败时仍返回200，persisted为false表示
+ *       重启前尚未保存；配置管理器保留脏标记，下次修改或写入时重试
+ */
+static esp_err_t save_config_api_handler(httpd_req_t *req) {
+    if (!is_authenticated(req)) {
+        send_json_response(req, 401, "{\"success\":false,\"message\":\"未认证\"}");
+        return ESP_OK;
+    }
+    
+    char *content = receive_body(req, CONFIG_API_MAX_BODY);
+    if (!content) {
+        send_json_response(req, 400, "{\"success\":false,\"message\":\"无效的请求数据\"}");
+        return ESP_OK;
+    }
+    cJSON *json = cJSON_Parse(content);
+    free(content);
+    if (!json) {
+        send_json_response(req, 400, "{\"success\":false,\"message\":\"JSON解析失败\"}");
+        return ESP_OK;
+    }
+    
+    // 在当前配置的副本上合并请求中的字段，副本在校验全部通过前不会发布
+    system_config_t *config = malloc(sizeof(system_config_t));
+    if (!config) {
+        cJSON_Delete(json);
+        send_json_response(req, 500, "{\"success\":false,\"message\":\"内存不足\"}");
+        return ESP_OK;
+    }
+    const system_config_t *current = config_manager_acquire(NULL);
+    if (!current) {
+        free(config);
+        cJSON_Delete(json);
+        send_json_response(req, 500, "{\"success\":false,\"message\":\"读取配置失败\"}");
+        return ESP_OK;
+    }
+    memcpy(config, current, sizeof(system_config_t));
+    
+    char error[96] = "";
+    uint32_t sections = 0;
+    esp_err_t ret = config_manager_from_json(json, config, &sections, error, sizeof(error));
+    cJSON_Delete(json);
+    
+    if (ret == ESP_OK) {
+        // 只检查本次提交的配置段，已保存的其他配置不影响本次请求
+        const struct {
+            uint32_t section;
+            const char* ip;
+        } addresses[] = {
+            { CONFIG_SECTION_WIFI_AP,  config->wifi_ap.ip },
+            { CONFIG_SECTION_ETHERNET, config->ethernet.ip },
+            { CONFIG_SECTION_ETHERNET, config->ethernet.netmask },
+            { CONFIG_SECTION_ETHERNET, config->ethernet.dns },
+            { CONFIG_SECTION_ETHERNET, config->ethernet.gateway },
+        };
+        for (size_t i = 0; i < sizeof(addresses) / sizeof(addresses[0]); i++) {
+            if ((sections & addresses[i].section) && !is_valid_ipv4(addresses[i].ip)) {
+                snprintf(error, sizeof(error), "IP地址格式无效: %s", addresses[i].ip);
+                ret = ESP_ERR_INVALID_ARG;
+                break;
+            }
+        }
+    }
+    bool ethernet_changed = memcmp(&config->ethernet, &current->ethernet, sizeof(ethernet_config_t)) != 0;
+    config_manager_release(current);
+    
+    if (ret != ESP_OK) {
+        free(config);
+        send_error_response(req, 400, error);
+        return ESP_OK;
+    }
+    
+    // 一次发布全部修改，订阅者只收到一次通知，随后立即写入文件而不是等待延迟写入
+    ret = config_manager_save(config);
+    free(config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "配置事务发布失败: %s", esp_err_to_name(ret));
+        send_error_response(req, 500, "配置保存失败");
+        return ESP_OK;
+    }
+    esp_err_t flush_ret = config_manager_flush();
+    bool persisted = flush_ret == ESP_OK;
+    if (!persisted) {
+        ESP_LOGE(TAG, "配置已生效但写入flash失败: %s", esp_err_to_name(flush_ret));
+    }
+    
+    ESP_LOGI(TAG, "配置事务已发布，配置段: 0x%03" PRIx32 ", 代数: %" PRIu32,
+             sections, config_manager_get_generation());
+    
+    // 配置已经生效，响应构建失败时仍继续重启以太网
+    char *json_string = NULL;
+    cJSON *response = cJSON_CreateObject();
+    if (response) {
+        cJSON_AddBoolToObject(response, "success", true);
+        cJSON_AddBoolToObject(response, "persisted", persisted);
+        cJSON_AddStringToObject(response, "message",
+                                persisted ? "配置已保存" : "配置已生效，但写入flash失败，重启后会丢失");
+        cJSON_AddNumberToObject(response, "generation", config_manager_get_generation());
+        if (ethernet_changed) {
+            cJSON_AddStringToObject(response, "restart_info", "以太网将在2秒后重启以应用新配置");
+        }
+        json_string = cJSON_PrintUnformatted(response);
+        cJSON_Delete(response);
+    }
+    if (json_string) {
+        send_json_response(req, 200, json_string);
+        free(json_string);
+    } else {
+        send_json_response(req, 500, "{\"success\":false,\"message\":\"内存不足\"}");
+    }
+    
+    // 以太网配置只在重启接口后生效，其他配置段由订阅者自行应用
+    if (ethernet_changed) {
+        xTaskCreate(restart_ethernet_task, "restart_eth", 4096, NULL, 2, NULL);
+    }
     return ESP_OK;
 }
 
@@ -1295,27 +1553,26 @@ static esp_err_t debug_api_handler(httpd_req_t *req) {
     auth_config_t auth_config;
     esp_err_t ret = config_manager_get_auth(&auth_config);
     
-    // 测试SHA-256计算
-    char test_hash[65];
-    auth_calculate_sha256("123456", test_hash);
+    // 只报告密码哈希的格式，不输出哈希本身
+    const char* scheme = "N/A";
+    if (ret == ESP_OK) {
+        scheme = strncmp(auth_config.password_hash, AUTH_PBKDF2_PREFIX, strlen(AUTH_PBKDF2_PREFIX)) == 0 ?
+                 "pbkdf2-sha256" : "sha256 (legacy, upgraded on next login)";
+    }
     
     // 构建调试信息JSON
-    char debug_info[1024];
+    char debug_info[256];
     snprintf(debug_info, sizeof(debug_info),
         "{"
         "\"config_load_result\":\"%s\","
         "\"config_username\":\"%s\","
-        "\"config_password_hash\":\"%s\","
-        "\"test_input\":\"123456\","
-        "\"test_calculated_hash\":\"%s\","
-        "\"expected_hash\":\"8d969eef6ecad3c29a3a629280e686cf0c3f5d5a86aff3ca12020c923adc6c92\","
-        "\"hash_match\":%s"
+        "\"password_scheme\":\"%s\","
+        "\"pbkdf2_iterations\":%d"
         "}",
         ret == ESP_OK ? "success" : "failed",
         ret == ESP_OK ? auth_config.username : "N/A",
-        ret == ESP_OK ? auth_config.password_hash : "N/A",
-        test_hash,
-        strcmp(test_hash, "8d969eef6ecad3c29a3a629280e686cf0c3f5d5a86aff3ca12020c923adc6c92") == 0 ? "true" : "false"
+        scheme,
+        ret == ESP_OK ? auth_config.pbkdf2_iterations : 0
     );
     
     send_json_response(req, 200, debug_info);
@@ -1381,6 +1638,127 @@ static esp_err_t change_password_api_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
+/**
+ * @brief 读取API密钥请求体中的name字段
+ * @note name只允许字母、数字和_.-，避免出现在响应和日志中时需要转义
+ * @return 成功返回ESP_OK，失败时已发送错误响应
+ */
+static esp_err_t receive_api_key_name(httpd_req_t *req, char* name) {
+    static const char allowed[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_.-";
+    char *content = receive_body(req, 256);
+    cJSON *json = content ? cJSON_Parse(content) : NULL;
+    free(content);
+    const char* value = cJSON_GetStringValue(cJSON_GetObjectItem(json, "name"));
+    size_t len = value ? strlen(value) : 0;
+    if (len == 0 || len > AUTH_API_KEY_NAME_MAX || strspn(value, allowed) != len) {
+        cJSON_Delete(json);
+        send_error_response(req, 400, "name必须是1~31个字母、数字或_.-");
+        return ESP_ERR_INVALID_ARG;
+    }
+    strcpy(name, value);
+    cJSON_Delete(json);
+    return ESP_OK;
+}
+
+/**
+ * @brief 列出API密钥，不返回密钥本身
+ */
+static esp_err_t list_api_keys_handler(httpd_req_t *req) {
+    if (!is_session_authenticated(req)) {
+        send_json_response(req, 401, "{\"success\":false,\"message\":\"未认证\"}");
+        return ESP_OK;
+    }
+    
+    auth_api_key_info_t keys[AUTH_MAX_API_KEYS];
+    int count = auth_list_api_keys(keys, AUTH_MAX_API_KEYS);
+    
+    cJSON *response = cJSON_CreateObject();
+    cJSON_AddBoolToObject(response, "success", true);
+    cJSON *array = cJSON_AddArrayToObject(response, "keys");
+    for (int i = 0; i < count; i++) {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", keys[i].name);
+        if (keys[i].used) {
+            cJSON_AddNumberToObject(item, "idle_seconds", keys[i].idle_seconds);
+        } else {
+            cJSON_AddNullToObject(item, "idle_seconds");
+        }
+        cJSON_AddItemToArray(array, item);
+    }
+    char *json_string = cJSON_PrintUnformatted(response);
+    cJSON_Delete(response);
+    send_json_response(req, json_string ? 200 : 500, json_string ? json_string : "{\"success\":false}");
+    free(json_string);
+    return ESP_OK;
+}
+
+/**
+ * @brief 创建API密钥，密钥只在此响应中返回一次
+ * @note 客户端以Authorization: Bearer <key>访问其他接口
+ */
+static esp_err_t create_api_key_handler(httpd_req_t *req) {
+    if (!is_session_authenticated(req)) {
+        send_json_response(req, 401, "{\"success\":false,\"message\":\"未认证\"}");
+        return ESP_OK;
+    }
+    
+    char name[AUTH_API_KEY_NAME_MAX + 1];
+    if (receive_api_key_name(req, name) != ESP_OK) {
+        return ESP_OK;
+    }
+    
+    char api_key[AUTH_API_KEY_LENGTH + 1];
+    esp_err_t ret = auth_create_api_key(name, api_key);
+    if (ret == ESP_ERR_INVALID_STATE) {
+        send_error_response(req, 400, "同名的API密钥已存在");
+        return ESP_OK;
+    }
+    if (ret == ESP_ERR_NO_MEM) {
+        send_error_response(req, 400, "API密钥数量已达上限");
+        return ESP_OK;
+    }
+    if (ret != ESP_OK) {
+        send_error_response(req, 500, "保存API密钥失败");
+        return ESP_OK;
+    }
+    
+    cJSON *response = cJSON_CreateObject();
+    cJSON_AddBoolToObject(response, "success", true);
+    cJSON_AddStringToObject(response, "name", name);
+    cJSON_AddStringToObject(response, "key", api_key);
+    char *json_string = cJSON_PrintUnformatted(response);
+    cJSON_Delete(response);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    send_json_response(req, json_string ? 200 : 500, json_string ? json_string : "{\"success\":false}");
+    free(json_string);
+    return ESP_OK;
+}
+
+/**
+ * @brief 吊销API密钥，立即生效
+ */
+static esp_err_t revoke_api_key_handler(httpd_req_t *req) {
+    if (!is_session_authenticated(req)) {
+        send_json_response(req, 401, "{\"success\":false,\"message\":\"未认证\"}");
+        return ESP_OK;
+    }
+    
+    char name[AUTH_API_KEY_NAME_MAX + 1];
+    if (receive_api_key_name(req, name) != ESP_OK) {
+        return ESP_OK;
+    }
+    
+    esp_err_t ret = auth_revoke_api_key(name);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        send_error_response(req, 404, "API密钥不存在");
+    } else if (ret != ESP_OK) {
+        send_error_response(req, 500, "已吊销，但保存失败，重启后会恢复");
+    } else {
+        send_json_response(req, 200, "{\"success\":true,\"message\":\"API密钥已吊销\"}");
+    }
+    return ESP_OK;
+}
+
 esp_err_t web_server_init(void) {
     // 初始化网络状态
     memset(&g_network_status, 0, sizeof(network_status_t));
@@ -1541,6 +1919,31 @@ esp_err_t web_server_start(void) {
     };
     httpd_register_uri_handler(g_server, &change_password_api_uri);
     
+    // API密钥管理
+    httpd_uri_t list_api_keys_uri = {
+        .uri = "/api/keys",
+        .method = HTTP_GET,
+        .handler = list_api_keys_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(g_server, &list_api_keys_uri);
+    
+    httpd_uri_t create_api_key_uri = {
+        .uri = "/api/keys",
+        .method = HTTP_POST,
+        .handler = create_api_key_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(g_server, &create_api_key_uri);
+    
+    httpd_uri_t revoke_api_key_uri = {
+        .uri = "/api/keys/revoke",
+        .method = HTTP_POST,
+        .handler = revoke_api_key_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(g_server, &revoke_api_key_uri);
+    
     httpd_uri_t debug_api_uri = {
         .uri = "/api/debug",
         .method = HTTP_GET,
@@ -1558,6 +1961,14 @@ esp_err_t web_server_start(void) {
     httpd_register_uri_handler(g_server, &reset_config_api_uri);
     
     // 注册配置保存API
+    httpd_uri_t save_config_uri = {
+        .uri = "/api/config",
+        .method = HTTP_POST,
+        .handler = save_config_api_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(g_server, &save_config_uri);
+    
     httpd_uri_t save_wifi_config_uri = {
         .uri = "/api/config/wifi",
         .method = HTTP_POST,
@@ -1609,10 +2020,12 @@ esp_err_t web_server_start(void) {
     ESP_LOGI(TAG, "  POST /api/logout - Logout API");
     ESP_LOGI(TAG, "  GET  /api/status - Status API");
     ESP_LOGI(TAG, "  GET  /api/config - Config API");
+    ESP_LOGI(TAG, "  POST /api/config - Config transaction API");
     ESP_LOGI(TAG, "  POST /api/config/wifi - WiFi config API");
     ESP_LOGI(TAG, "  POST /api/config/ethernet - Ethernet config API");
     ESP_LOGI(TAG, "  POST /api/config/bluetooth - Bluetooth config API");
     ESP_LOGI(TAG, "  POST /api/config/mqtt - MQTT config API");
+    ESP_LOGI(TAG, "  GET/POST /api/keys, POST /api/keys/revoke - API key management");
     return ESP_OK;
 }
 